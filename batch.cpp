@@ -0,0 +1,159 @@
+// Headless batch exporter: samples and transforms every expression of a
+// manifest without a window (see README, "Batch export").
+#include "src/Batch.h"
+#include "src/InputRecord.h"
+#include "src/FFT.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <chrono>
+
+static int Usage() {
+    std::fprintf(stderr,
+        "usage: fvbatch <manifest> [-o dir] [-f csv|bin] [-j threads] [--budget ms]\n"
+        "               [--no-curves] [--no-spectra] [--png width]\n"
+        "       fvbatch --replay <recording> [--step s] [--budget ms] [--frames csv]\n"
+        "       fvbatch --tune-fft <n|a-b>[,...] [--wisdom file]\n");
+    return 2;
+}
+
+// per-frame cost percentiles of a recorded session, optionally every frame as CSV
+static int Replay(const std::string& path, const ReplayOptions& opt, const std::string& framesCsv) {
+    InputRecording rec;
+    std::string error;
+    if (!rec.load(path, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+    const ReplayResult r = ReplayRecording(rec, opt);
+    if (!r.ok) {
+        std::fprintf(stderr, "%s\n", r.error.c_str());
+        return 1;
+    }
+    std::printf("%-10s %10s %10s %10s %10s %10s\n", "phase", "mean", "p50", "p90", "p99", "max");
+    const std::pair<const char*, double FrameCost::*> phases[] = {
+        { "input", &FrameCost::inputMs }, { "curve", &FrameCost::curveMs },
+        { "spectrum", &FrameCost::spectrumMs }, { "render", &FrameCost::renderMs },
+        { "total", &FrameCost::totalMs },
+    };
+    for (const auto& [name, field] : phases) {
+        const CostSummary s = Summarize(r.frames, field);
+        std::printf("%-10s %8.3fms %8.3fms %8.3fms %8.3fms %8.3fms\n", name, s.mean, s.p50, s.p90, s.p99, s.max);
+    }
+    std::printf("\n%d frames, %d compile waits (%.1f ms, not counted in frames)\n",
+        (int)r.frames.size(), r.compiles, r.compileMs);
+
+    if (!framesCsv.empty()) {
+        FILE* f = std::fopen(framesCsv.c_str(), "w");
+        if (!f) {
+            std::fprintf(stderr, "cannot write %s\n", framesCsv.c_str());
+            return 1;
+        }
+        std::fprintf(f, "frame,input,curve,spectrum,render,total\n");
+        for (size_t i = 0; i < r.frames.size(); ++i) {
+            const FrameCost& c = r.frames[i];
+            std::fprintf(f, "%zu,%.4f,%.4f,%.4f,%.4f,%.4f\n", i, c.inputMs, c.curveMs, c.spectrumMs, c.renderMs, c.totalMs);
+        }
+        std::fclose(f);
+    }
+    return 0;
+}
+
+// measure FFT plans for the listed sizes ("500,1024,4000-4100") and store the winners
+static int TuneFft(const std::string& sizes, const std::string& wisdom) {
+    std::vector<int> ns;
+    size_t pos = 0;
+    while (pos <= sizes.size()) {
+        size_t end = sizes.find(',', pos);
+        if (end == std::string::npos) end = sizes.size();
+        const std::string item = sizes.substr(pos, end - pos);
+        pos = end + 1;
+        if (item.empty()) continue;
+        const size_t dash = item.find('-');
+        const int a = std::atoi(item.c_str());
+        const int b = dash == std::string::npos ? a : std::atoi(item.c_str() + dash + 1);
+        if (a < 1 || b < a || b > (1 << 24)) return Usage();
+        for (int n = a; n <= b; ++n) ns.push_back(n);
+    }
+    if (ns.empty()) return Usage();
+
+    FFT::loadWisdom(wisdom);
+    std::printf("%8s %12s  %s\n", "N", "forward", "plan");
+    for (int n : ns) {
+        const FFT::Choice c = FFT::tune(n);
+        std::printf("%8d %10.2fus  %s\n", n, c.ns / 1000.0, FFT::describe(n).c_str());
+    }
+    if (!FFT::saveWisdom(wisdom)) {
+        std::fprintf(stderr, "cannot write %s\n", wisdom.c_str());
+        return 1;
+    }
+    std::printf("\n%d sizes saved to %s\n", (int)ns.size(), wisdom.c_str());
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    BatchOptions opt;
+    ReplayOptions replay;
+    std::string manifest, recording, framesCsv, tuneSizes;
+    std::string wisdom = "fft_wisdom.txt";
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(a, "-o") && hasValue) opt.outDir = argv[++i];
+        else if (!std::strcmp(a, "-f") && hasValue) {
+            const std::string f = argv[++i];
+            if (f == "csv") opt.format = BATCH_CSV;
+            else if (f == "bin") opt.format = BATCH_BINARY;
+            else return Usage();
+        }
+        else if (!std::strcmp(a, "-j") && hasValue) opt.threads = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--budget") && hasValue) opt.budgetMs = replay.budgetMs = (float)std::atof(argv[++i]);
+        else if (!std::strcmp(a, "--replay") && hasValue) recording = argv[++i];
+        else if (!std::strcmp(a, "--step") && hasValue) replay.step = (float)std::atof(argv[++i]);
+        else if (!std::strcmp(a, "--frames") && hasValue) framesCsv = argv[++i];
+        else if (!std::strcmp(a, "--tune-fft") && hasValue) tuneSizes = argv[++i];
+        else if (!std::strcmp(a, "--wisdom") && hasValue) wisdom = argv[++i];
+        else if (!std::strcmp(a, "--png") && hasValue) opt.pngWidth = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--no-curves")) opt.curves = false;
+        else if (!std::strcmp(a, "--no-spectra")) opt.spectra = false;
+        else if (a[0] != '-' && manifest.empty()) manifest = a;
+        else return Usage();
+    }
+    if (!tuneSizes.empty()) return TuneFft(tuneSizes, wisdom);
+    // measured plans if there are any; untuned sizes keep the default plan
+    FFT::loadWisdom(wisdom);
+    if (!recording.empty()) return Replay(recording, replay, framesCsv);
+    if (manifest.empty()) return Usage();
+
+    std::vector<BatchJob> jobs;
+    std::string error;
+    if (!LoadManifest(manifest, jobs, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const std::vector<BatchResult> results = RunBatch(jobs, opt);
+    const double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    std::printf("%-24s %8s %10s %10s %10s %10s %10s  %s\n",
+        "job", "N", "compile", "curve", "spectrum", "png", "total", "status");
+    int failed = 0;
+    long long points = 0;
+    for (const BatchResult& r : results) {
+        const char* status = !r.ok ? "FAILED" : (r.aborted ? "over budget" : "ok");
+        std::printf("%-24s %8d %8.2fms %8.2fms %8.2fms %8.2fms %8.2fms  %s\n", r.name.c_str(), r.samples,
+            r.compileMs, r.curveMs, r.spectrumMs, r.pngMs, r.totalMs, status);
+        if (!r.ok) {
+            std::printf("    %s\n", r.error.c_str());
+            ++failed;
+        }
+        else points += (long long)r.samples * ((opt.curves ? 1 : 0) + (opt.spectra ? 1 : 0));
+    }
+    const double seconds = wallMs / 1000.0;
+    std::printf("\n%d jobs (%d failed) in %.1f ms: %.1f jobs/s, %.3g points/s\n",
+        (int)results.size(), failed, wallMs,
+        seconds > 0 ? results.size() / seconds : 0.0, seconds > 0 ? points / seconds : 0.0);
+    return failed ? 1 : 0;
+}
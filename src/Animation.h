@@ -52,3 +52,44 @@ struct ScaleAnimation {
         return lastValue;
     }
 };
+
+// Wheel zoom: a critically damped spring in exponent space (log of the grid
+// scale), so every wheel notch zooms by the same factor
+struct ZoomSpring {
+    float zoomExp = 0.0f;     // current exp
+    float targetExp = 0.0f;   // target exp
+    float expVel = 0.0f;      // velocity in exp space
+    float omega = 12.0f;      // responsiveness
+
+    static float ToExp(float scale) { return std::log(scale / 100.0f); }
+    static float FromExp(float exp) { return 100.0f * std::exp(exp); }
+
+    void Reset(float scale) {
+        zoomExp = targetExp = ToExp(scale);
+        expVel = 0.0f;
+    }
+
+    // 15% per wheel unit
+    void Wheel(float delta) { targetExp += delta * std::log(1.0f + 0.15f); }
+
+    // exp(0) = 1 -> scale = 100
+    void Home() { targetExp = 0.0f; }
+
+    // advance by dt seconds, returns the grid scale (%)
+    float Update(float dt) {
+        float x = zoomExp - targetExp;
+        float a = -2.0f * omega * expVel - (omega * omega) * x;
+        expVel += a * dt;
+        zoomExp += expVel * dt;
+
+        float scale = FromExp(zoomExp);
+        scale = scale < 10.0f ? 10.0f : (scale > 500.0f ? 500.0f : scale);
+        // snap when close
+        if (std::fabs(scale - FromExp(targetExp)) < 0.01f && std::fabs(expVel) < 0.01f) {
+            zoomExp = targetExp;
+            expVel = 0.0f;
+            scale = FromExp(targetExp);
+        }
+        return scale;
+    }
+};
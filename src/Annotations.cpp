@@ -0,0 +1,167 @@
+#include "Annotations.h"
+#include "ThreadPool.h"
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+std::vector<Bracket> scanBrackets(const std::vector<double>& ys, double xMin, double dx,
+    int maxBrackets)
+{
+    std::vector<Bracket> out;
+    const int N = (int)ys.size();
+    if (N < 3) return out;
+
+    // branch-free flag passes so the compiler can vectorize them
+    std::vector<uint8_t> pos(N), rise(N - 1), fin(N);
+    for (int i = 0; i < N; ++i) {
+        pos[i] = ys[i] > 0.0;
+        fin[i] = std::isfinite(ys[i]);
+    }
+    for (int i = 0; i < N - 1; ++i) rise[i] = ys[i + 1] > ys[i];
+
+    std::vector<uint8_t> zero(N - 1), turn(N - 2);
+    for (int i = 0; i < N - 1; ++i) zero[i] = (pos[i] ^ pos[i + 1]) & fin[i] & fin[i + 1];
+    for (int i = 0; i < N - 2; ++i) turn[i] = (rise[i] ^ rise[i + 1]) & fin[i] & fin[i + 1] & fin[i + 2];
+
+    for (int i = 0; i < N - 1 && (int)out.size() < maxBrackets; ++i) {
+        if (zero[i]) out.push_back({ FEATURE_ROOT, xMin + i * dx, xMin + (i + 1) * dx });
+        if (i < N - 2 && turn[i]) {
+            const int kind = rise[i] ? FEATURE_MAXIMUM : FEATURE_MINIMUM;
+            out.push_back({ kind, xMin + i * dx, xMin + (i + 2) * dx });
+        }
+    }
+    return out;
+}
+
+// Brent's zero finder on a sign-change bracket
+static double brentZero(const std::function<double(double)>& f, double a, double b,
+    double fa, double fb, double tol)
+{
+    double c = a, fc = fa, d = b - a, e = d;
+    for (int iter = 0; iter < 100; ++iter) {
+        if ((fb > 0) == (fc > 0)) { c = a; fc = fa; d = e = b - a; }
+        if (std::fabs(fc) < std::fabs(fb)) {
+            a = b; b = c; c = a;
+            fa = fb; fb = fc; fc = fa;
+        }
+        const double tol1 = 2.0 * 1e-12 * std::fabs(b) + 0.5 * tol;
+        const double m = 0.5 * (c - b);
+        if (std::fabs(m) <= tol1 || fb == 0.0) return b;
+
+        if (std::fabs(e) >= tol1 && std::fabs(fa) > std::fabs(fb)) {
+            double p, q, r;
+            const double s = fb / fa;
+            if (a == c) {   // secant
+                p = 2.0 * m * s;
+                q = 1.0 - s;
+            }
+            else {          // inverse quadratic interpolation
+                q = fa / fc;
+                r = fb / fc;
+                p = s * (2.0 * m * q * (q - r) - (b - a) * (r - 1.0));
+                q = (q - 1.0) * (r - 1.0) * (s - 1.0);
+            }
+            if (p > 0) q = -q; else p = -p;
+            if (2.0 * p < std::min(3.0 * m * q - std::fabs(tol1 * q), std::fabs(e * q))) {
+                e = d;
+                d = p / q;
+            }
+            else { d = m; e = m; }
+        }
+        else { d = m; e = m; }
+
+        a = b; fa = fb;
+        b += (std::fabs(d) > tol1) ? d : (m > 0 ? tol1 : -tol1);
+        fb = f(b);
+    }
+    return b;
+}
+
+// Brent's minimizer (golden section with parabolic steps) on [a, b]
+static double brentMin(const std::function<double(double)>& f, double a, double b, double tol) {
+    const double golden = 0.3819660112501051;
+    double x = a + golden * (b - a), w = x, v = x;
+    double fx = f(x), fw = fx, fv = fx;
+    double d = 0.0, e = 0.0;
+    for (int iter = 0; iter < 100; ++iter) {
+        const double xm = 0.5 * (a + b);
+        const double tol1 = 1e-10 * std::fabs(x) + 0.5 * tol, tol2 = 2.0 * tol1;
+        if (std::fabs(x - xm) <= tol2 - 0.5 * (b - a)) break;
+
+        bool golden_step = true;
+        if (std::fabs(e) > tol1) {
+            double r = (x - w) * (fx - fv);
+            double q = (x - v) * (fx - fw);
+            double p = (x - v) * q - (x - w) * r;
+            q = 2.0 * (q - r);
+            if (q > 0.0) p = -p; else q = -q;
+            if (std::fabs(p) < std::fabs(0.5 * q * e) && p > q * (a - x) && p < q * (b - x)) {
+                e = d;
+                d = p / q;
+                golden_step = false;
+            }
+        }
+        if (golden_step) {
+            e = (x >= xm) ? a - x : b - x;
+            d = golden * e;
+        }
+        const double u = x + (std::fabs(d) >= tol1 ? d : (d > 0 ? tol1 : -tol1));
+        const double fu = f(u);
+        if (fu <= fx) {
+            if (u >= x) a = x; else b = x;
+            v = w; fv = fw; w = x; fw = fx; x = u; fx = fu;
+        }
+        else {
+            if (u < x) a = u; else b = u;
+            if (fu <= fw || w == x) { v = w; fv = fw; w = u; fw = fu; }
+            else if (fu <= fv || v == x || v == w) { v = u; fv = fu; }
+        }
+    }
+    return x;
+}
+
+std::vector<Feature> refineBrackets(const std::vector<Bracket>& brackets,
+    const std::function<double(int, double)>& f, int slots)
+{
+    const int count = (int)brackets.size();
+    std::vector<Feature> out(count);
+    if (count == 0) return out;
+    const int lanes = std::max(1, std::min(slots, count));
+
+    ThreadPool::Shared().parallelFor(0, lanes, [&](int lane) {
+        auto g = [&](double x) { return f(lane, x); };
+        for (int i = lane; i < count; i += lanes) {
+            const Bracket& br = brackets[i];
+            const double tol = 1e-7 * std::max(1.0, std::fabs(br.b - br.a));
+            Feature& ft = out[i];
+            ft.kind = br.kind;
+            if (br.kind == FEATURE_ROOT) {
+                const double fa = g(br.a), fb = g(br.b);
+                ft.x = brentZero(g, br.a, br.b, fa, fb, tol);
+                ft.y = g(ft.x);
+                // a sign change whose magnitude grows toward the crossing is a pole
+                if (!std::isfinite(ft.y) || std::fabs(ft.y) > std::max(std::fabs(fa), std::fabs(fb)))
+                    ft.kind = FEATURE_POLE;
+                else
+                    ft.y = 0.0;
+            }
+            else {
+                const double sign = br.kind == FEATURE_MAXIMUM ? -1.0 : 1.0;
+                ft.x = brentMin([&](double x) { return sign * g(x); }, br.a, br.b, tol);
+                ft.y = g(ft.x);
+                if (!std::isfinite(ft.y)) ft.kind = FEATURE_POLE;
+            }
+        }
+    });
+
+    // derivative sign flips right next to a pole are not extrema
+    std::vector<double> poles;
+    for (const auto& ft : out) if (ft.kind == FEATURE_POLE) poles.push_back(ft.x);
+    const double reach = brackets.front().b - brackets.front().a;
+    out.erase(std::remove_if(out.begin(), out.end(), [&](const Feature& ft) {
+        if (ft.kind != FEATURE_MAXIMUM && ft.kind != FEATURE_MINIMUM) return false;
+        for (double p : poles) if (std::fabs(ft.x - p) < reach) return true;
+        return false;
+    }), out.end());
+    return out;
+}
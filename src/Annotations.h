@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+#include <functional>
+
+enum FeatureKind {
+    FEATURE_ROOT = 0,
+    FEATURE_MAXIMUM,
+    FEATURE_MINIMUM,
+    FEATURE_POLE,
+};
+
+struct Feature {
+    int kind = FEATURE_ROOT;
+    double x = 0.0;
+    double y = 0.0;
+};
+
+struct Bracket {
+    int kind = FEATURE_ROOT;   // FEATURE_ROOT covers poles until refinement tells them apart
+    double a = 0.0;
+    double b = 0.0;
+};
+
+// Sign-change scan over an existing uniform sample buffer (no evaluations).
+// Sign changes of y bracket roots or poles, sign changes of the first
+// difference bracket extrema. At most maxBrackets are returned.
+std::vector<Bracket> scanBrackets(const std::vector<double>& ys, double xMin, double dx,
+    int maxBrackets = 2048);
+
+// Refine brackets in parallel: Brent's zero finder for sign changes, Brent's
+// minimizer for extrema. f(slot, x) gets a distinct slot per concurrent lane.
+std::vector<Feature> refineBrackets(const std::vector<Bracket>& brackets,
+    const std::function<double(int, double)>& f, int slots);
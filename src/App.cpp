@@ -2,6 +2,15 @@
 #include <imgui/imgui_impl_win32.h>
 #include <tchar.h>
 #include <algorithm>
+#include "PlotExport.h"
+#include "FFT.h"
+#include "Workspace.h"
+#include "FontCache.h"
+#include "Timing.h"
+#include <sstream>
+#include <chrono>
+#include <future>
+#include <cstdio>
 
 #ifdef max
 #undef max
@@ -14,6 +23,14 @@
 
 static App* g_app = nullptr;
 
+using Clock = std::chrono::steady_clock;
+
+// UI font, also baked at the output scale for PNG export
+static const char* const kFontPath = "C:\\Windows\\Fonts\\arial.ttf";
+
+// longest the first frame waits for the snapshot's expression to compile
+static const double kCompileBudgetMs = 250.0;
+
 // Forward Win32 proc
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND, UINT, WPARAM, LPARAM);
 static LRESULT CALLBACK StaticWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
@@ -55,21 +72,82 @@ void App::DestroyMainWindow() {
     UnregisterClassW(m_className.c_str(), m_hInst);
 }
 
+void App::LoadSession(StartupTimes& st) {
+    const auto t0 = Clock::now();
+    // Load config; FFT plans come from wisdom, sizes without it are measured on first use
+    const bool haveConfig = m_cfg.Load("config.ini", m_scene);
+    FFT::loadWisdom("fft_wisdom.txt");
+
+    // warm start: results of the last session, each used only if its inputs still match
+    WorkspaceCache workspace;
+    std::string workspaceError;
+    if (m_cfg.workspaceSnapshot && LoadWorkspace("workspace.fvs", workspace, workspaceError)) {
+        if (!haveConfig) {
+            std::istringstream is(workspace.config);
+            std::string header;
+            std::getline(is, header);
+            m_cfg.layers.clear();
+            m_cfg.ApplyKV(is, m_scene);
+        }
+        m_scene.ImportCache(workspace);
+        // the first frame needs the program the cached results belong to, but
+        // waits for it only so long; a slower compile installs on a later frame
+        st.compiled = m_scene.FinishCompiling(kCompileBudgetMs);
+    }
+    st.session = MsSince(t0);
+}
+
+void App::ReportStartup(const StartupTimes& st) {
+    char summary[64], phases[512];
+    std::snprintf(summary, sizeof(summary), "Startup: first frame at %.0f ms", st.firstFrame);
+    std::snprintf(phases, sizeof(phases),
+        "window %.1f ms, D3D9 device %.1f ms, ImGui init %.1f ms\n"
+        "alongside: font atlas %.1f ms (%s), config + snapshot + compile %.1f ms%s\n"
+        "UI thread waited %.1f ms for them",
+        st.window, st.device, st.gui, st.fonts, st.fontFromCache ? "cached" : "rasterized",
+        st.session, st.compiled ? "" : " (compile still running)", st.waited);
+    m_gui.SetStartupReport(summary, phases);
+}
+
 int App::Run() {
+    // Startup: the font atlas (baked once, then loaded from font_atlas.bin)
+    // and the session load on their own threads while the window and the
+    // D3D9 device are created; the UI thread joins them where it needs them
+    const auto t0 = Clock::now();
+    StartupTimes st;
+    m_fonts = std::make_unique<ImFontAtlas>();
+    auto fonts = std::async(std::launch::async, [this, &st] {
+        const auto t = Clock::now();
+        // Cyrillic glyphs; the ranges array is static, as the atlas requires
+        const FontLoad f = LoadFontCached(*m_fonts, kFontPath, 14.0f,
+            m_fonts->GetGlyphRangesCyrillic(), "font_atlas.bin");
+        st.fontFromCache = f.fromCache;
+        st.fonts = MsSince(t);
+    });
+    auto session = std::async(std::launch::async, [this, &st] { LoadSession(st); });
+
+    auto t = Clock::now();
     if (!CreateMainWindow()) return 1;
+    st.window = MsSince(t);
+    t = Clock::now();
     if (!m_renderer.Init(m_hWnd)) { DestroyMainWindow(); return 1; }
-
-    // ImGui init
-    m_gui.Init(m_hWnd, m_renderer);
-
-    // Fonts (optional, Cyrillic)
+    st.device = MsSince(t);
+
+    // ImGui init on the prebuilt atlas
+    t = Clock::now();
+    fonts.get();
+    st.waited = MsSince(t);
+    t = Clock::now();
+    m_gui.Init(m_hWnd, m_renderer, m_fonts.get());
     ImGuiIO& io = ImGui::GetIO();
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard | ImGuiConfigFlags_NavEnableGamepad;
-    ImFont* font = io.Fonts->AddFontFromFileTTF("C:\\Windows\\Fonts\\arial.ttf", 14.0f, nullptr, io.Fonts->GetGlyphRangesCyrillic());
-    (void)font;
+    st.gui = MsSince(t);
 
-    // Load config
-    m_cfg.Load("config.ini", m_scene);
+    t = Clock::now();
+    session.get();
+    st.waited += MsSince(t);
+    FFT::setAutotune(true);
+    m_zoom.Reset((float)m_cfg.gridScale);
 
     // Main loop
     MSG msg = {};
@@ -90,44 +168,21 @@ int App::Run() {
         m_prevTime = now;
         if (dt > 0.1f) dt = 0.1f;
 
-        // convert current scale to exponent form (logarithmic zoom space)
-        auto ToExp = [](float scale) { return std::log(scale / 100.0f); };
-        auto FromExp = [](float exp) { return 100.0f * std::exp(exp); };
-
-        static float zoomExp = ToExp(m_cfg.gridScale);   // current exp
-        static float targetExp = zoomExp;                // target exp
-        static float expVel = 0.0f;                      // velocity in exp space
+        // 1. wheel and R (reset) drive the zoom spring
+        m_recorder.frameInput(dt, io.MouseWheel, io.KeysDown['R'], io.DisplaySize);
+        if (io.MouseWheel != 0.0f) m_zoom.Wheel(io.MouseWheel);
+        if (io.KeysDown['R']) m_zoom.Home();
 
-        // 1. accumulate target from wheel input
-        if (io.MouseWheel != 0.0f) {
-            float step = 0.15f; // 15% per wheel unit
-            targetExp += io.MouseWheel * std::log(1.0f + step);
-        }
-
-        // 2. reset on R
-        if (io.KeysDown['R']) {
-            targetExp = 0.0f; // exp(0) = 1 → scale=100
-        }
+        // 2. spring smoothing in exp space, back to the grid scale
+        m_cfg.gridScale = (int)m_zoom.Update(dt);
 
-        // 3. spring smoothing in exp space
-        const float omega = 12.0f; // responsiveness
-        float x = zoomExp - targetExp;
-        float a = -2.0f * omega * expVel - (omega * omega) * x;
-        expVel += a * dt;
-        zoomExp += expVel * dt;
-
-        // 4. convert back to scale, clamp
-        m_cfg.gridScale = std::clamp(FromExp(zoomExp), 10.0f, 500.0f);
-
-        // snap when close
-        if (fabs(m_cfg.gridScale - FromExp(targetExp)) < 0.01f && fabs(expVel) < 0.01f) {
-            zoomExp = targetExp;
-            expVel = 0.0f;
-            m_cfg.gridScale = FromExp(targetExp);
-        }
+        // 3. animation clock, read by expressions as t
+        if (m_cfg.animate) m_cfg.time += dt * m_cfg.timeSpeed;
         
-        // GUI panels
+        // GUI panels; the recorder keeps what they changed
+        m_recorder.beforeGui(m_cfg);
         m_gui.ShowMainMenu(m_cfg, m_scene);
+        m_recorder.afterGui(m_cfg);
 
         // Sizes
         ImVec2 winSize = ImGui::GetIO().DisplaySize;
@@ -155,10 +210,48 @@ int App::Run() {
             m_gui.EndFrame(m_renderer);
         }
         m_renderer.EndFrame();
+        if (st.firstFrame == 0.0) {
+            st.firstFrame = MsSince(t0);
+            ReportStartup(st);
+        }
+
+        // 4. high-resolution export, in its own ImGui context after the frame
+        int exportWidth = 0;
+        std::string exportPath;
+        if (m_gui.TakeExportRequest(exportWidth, exportPath)) {
+            std::string error;
+            const bool ok = ExportPlotPng(m_scene, m_cfg, winSize, exportWidth, exportPath, error, kFontPath);
+            m_gui.SetExportStatus(ok ? "Saved " + exportPath : error);
+        }
+
+        // 5. input recording
+        std::string recordPath;
+        if (m_gui.TakeRecordToggle(recordPath)) {
+            if (!m_recorder.active()) {
+                m_recorder.start(m_cfg, m_zoom);
+                m_gui.SetRecording(true, "Recording...");
+            }
+            else {
+                const int frames = m_recorder.frames();
+                std::string error;
+                const bool ok = m_recorder.stop(recordPath, error);
+                m_gui.SetRecording(false, ok ? "Saved " + std::to_string(frames) + " frames to " + recordPath : error);
+            }
+        }
     }
 
     // Save config on exit
     m_cfg.Save("config.ini");
+    if (m_cfg.workspaceSnapshot) {
+        WorkspaceCache snapshot;
+        std::ostringstream os;
+        m_cfg.Write(os);
+        snapshot.config = os.str();
+        m_scene.ExportCache(snapshot);
+        std::string error;
+        SaveWorkspace("workspace.fvs", snapshot, error);
+    }
+    if (FFT::wisdomDirty()) FFT::saveWisdom("fft_wisdom.txt");
 
     // Shutdown
     m_gui.Shutdown();
@@ -1,11 +1,25 @@
 #pragma once
 #include <windows.h>
 #include <string>
+#include <memory>
 #include "RendererDX9.h"
 #include "GuiManager.h"
 #include "Scene.h"
 #include "Config.h"
 #include "Animation.h"
+#include "InputRecord.h"
+
+// Wall-clock milliseconds of the startup phases. Fonts and the session load
+// on their own threads while the window and the device are created.
+struct StartupTimes {
+    double window = 0.0, device = 0.0, gui = 0.0;
+    double fonts = 0.0;         // atlas from the cache or rasterized
+    double session = 0.0;       // config, FFT wisdom, workspace snapshot, first compile
+    double waited = 0.0;        // UI thread blocked on the two above
+    double firstFrame = 0.0;    // Run() to the first presented frame
+    bool fontFromCache = false;
+    bool compiled = true;       // the snapshot's program compiled within the budget
+};
 
 class App {
 public:
@@ -19,6 +33,9 @@ public:
 private:
     bool CreateMainWindow();
     void DestroyMainWindow();
+    // config, FFT wisdom and workspace snapshot; off the UI thread, no ImGui
+    void LoadSession(StartupTimes& st);
+    void ReportStartup(const StartupTimes& st);
 
 private:
     HINSTANCE   m_hInst = nullptr;
@@ -28,9 +45,12 @@ private:
 
     RendererDX9 m_renderer;
     GuiManager  m_gui;
+    std::unique_ptr<ImFontAtlas> m_fonts;   // shared with the ImGui context, outlives it
     Scene       m_scene;
     AppConfig   m_cfg;
     ScaleAnimation m_scaleAnim;
+    ZoomSpring  m_zoom;
+    InputRecorder m_recorder;
 
     float  m_targetScale = 100.0f;
     float m_scaleVel = 0.0f;
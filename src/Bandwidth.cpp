@@ -0,0 +1,162 @@
+#include "Bandwidth.h"
+#include "FFT.h"
+#include <cmath>
+#include <complex>
+#include <algorithm>
+
+static const int kFirstPoints = 256;
+static const int kMinPoints = 16;
+
+void BandwidthProbe::clear() {
+    signalId_ = ~0ull;
+    tol_ = -1.0;
+    valid_ = false;
+    resolved_ = false;
+    points_ = 0;
+    band_ = 0;
+    x_.clear();
+    check_.clear();
+    tail_.clear();
+}
+
+// n + 1 samples of [a, b]
+static void sampleGrid(const std::function<double(double)>& f, double a, double b, int n, std::vector<double>& x) {
+    x.resize(n + 1);
+    for (int i = 0; i <= n; ++i) x[i] = f(a + (b - a) * i / n);
+}
+
+// the same grid at twice the density, only the new midpoints are evaluated
+static void refineGrid(const std::function<double(double)>& f, double a, double b,
+    const std::vector<double>& x, std::vector<double>& finer)
+{
+    const int n = (int)x.size() - 1;
+    finer.resize(2 * n + 1);
+    for (int i = 0; i <= n; ++i) finer[2 * i] = x[i];
+    for (int i = 0; i < n; ++i) finer[2 * i + 1] = f(a + (b - a) * (2 * i + 1) / (2 * n));
+}
+
+// tail[k]: fraction of the energy in bins >= k of the detrended, Hann-windowed
+// samples. Non-finite samples sit on the trend line, so they add nothing.
+// Returns the number of finite samples.
+static int energyTail(const std::vector<double>& x, std::vector<std::complex<double>>& z, std::vector<double>& tail) {
+    const int M = (int)x.size() - 1;
+    int first = 0, last = M, finite = 0;
+    while (first <= M && !std::isfinite(x[first])) ++first;
+    while (last > first && !std::isfinite(x[last])) --last;
+    for (double v : x) finite += std::isfinite(v) ? 1 : 0;
+
+    const int half = M / 2;
+    tail.assign(half + 2, 0.0);
+    if (finite < 2) return finite;
+
+    // the line through the outermost finite samples goes, the window makes the rest periodic
+    const double slope = (x[last] - x[first]) / (last - first);
+    z.resize(M);
+    for (int i = 0; i < M; ++i) {
+        const double v = std::isfinite(x[i]) ? x[i] - (x[first] + slope * (i - first)) : 0.0;
+        z[i] = v * (0.5 - 0.5 * std::cos(2.0 * M_PI * i / M));
+    }
+    FFT(M).forward(z);
+
+    for (int k = half; k >= 0; --k) {
+        double p = std::norm(z[k]);
+        if (k > 0 && k < half) p += std::norm(z[M - k]);
+        tail[k] = tail[k + 1] + p;
+    }
+    const double total = tail[0];
+    if (total > 0.0)
+        for (double& t : tail) t /= total;
+    return finite;
+}
+
+static int bandOf(const std::vector<double>& tail, double tol) {
+    int k = 0;
+    while (k + 1 < (int)tail.size() && tail[k + 1] > tol * tol) ++k;
+    return k;
+}
+
+// A dyadic grid alone can be fooled: a tone above its Nyquist folds onto the
+// same low bin at every doubling. The check grid, 3/4 as dense, folds it
+// somewhere else, so both only agree once the grid resolves f.
+void BandwidthProbe::update() {
+    std::vector<std::complex<double>> z;
+    std::vector<double> checkTail;
+    const int M = points_;
+    const int finite = energyTail(x_, z, tail_);
+    const int checkFinite = energyTail(check_, z, checkTail);
+    valid_ = finite >= 2 && checkFinite >= 2;
+    if (!valid_) {
+        resolved_ = true;   // nothing more to learn from a finer grid
+        band_ = 0;
+        return;
+    }
+    const double floor = 0.01 * tol_ * tol_;
+    band_ = bandOf(tail_, tol_);
+    const int checkBand = bandOf(checkTail, tol_);
+    // the top quarter should sit well under the tolerance before trusting the grid
+    resolved_ = tail_[M / 4] <= floor && checkTail[3 * M / 16] <= floor &&
+        std::abs(band_ - checkBand) <= std::max(2, band_ / 8);
+}
+
+void BandwidthProbe::estimate(const std::function<double(double)>& f, unsigned long long signalId,
+    double a, double b, double tol, int maxPoints, const std::function<bool()>& interrupted)
+{
+    if (signalId != signalId_ || a != a_ || b != b_ || tol != tol_) {
+        clear();
+        signalId_ = signalId;
+        a_ = a;
+        b_ = b;
+        tol_ = tol;
+    }
+    if (!(b > a) || !(tol > 0.0)) return;
+
+    if (x_.empty()) {
+        int M = kFirstPoints;
+        while (M > kMinPoints && M > maxPoints) M /= 2;
+        std::vector<double> x, check;
+        sampleGrid(f, a, b, M, x);
+        sampleGrid(f, a, b, 3 * M / 4, check);
+        if (interrupted()) return;
+        x_.swap(x);
+        check_.swap(check);
+        points_ = M;
+        update();
+    }
+
+    std::vector<double> finer, finerCheck;
+    while (!resolved_ && 2 * points_ <= maxPoints) {
+        refineGrid(f, a, b, x_, finer);
+        refineGrid(f, a, b, check_, finerCheck);
+        if (interrupted()) return;
+        x_.swap(finer);
+        check_.swap(finerCheck);
+        points_ *= 2;
+        update();
+    }
+}
+
+double BandwidthProbe::bandwidth() const {
+    return valid_ ? 2.0 * M_PI * band_ / (b_ - a_) : 0.0;
+}
+
+double BandwidthProbe::aliasError(int n) const {
+    if (!valid_) return 0.0;
+    // bins above n / 2 fold back; past the coarse grid nothing more is known
+    const int k = std::min(n / 2 + 1, (int)tail_.size() - 1);
+    return std::sqrt(tail_[std::max(k, 0)]);
+}
+
+int BandwidthProbe::smoothSize(int n) {
+    for (int m = std::max(n, 1);; ++m) {
+        int r = m;
+        for (int p : { 2, 3, 5 })
+            while (r % p == 0) r /= p;
+        if (r == 1) return m;
+    }
+}
+
+int BandwidthProbe::spectrumSize(double tol, int minN, int maxN) const {
+    int n = smoothSize(std::max(minN, 2 * band_ + 2));
+    while (n < maxN && aliasError(n) > tol) n = smoothSize(n + 1);
+    return std::min(n, maxN);
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+#include <functional>
+
+// Effective bandwidth of f over a window, from a cheap coarse spectrum.
+// f is sampled on a uniform grid, detrended, Hann-windowed and transformed;
+// while the top quarter of the spectrum still holds more than a small part of
+// the energy the grid is doubled (reusing the samples already taken), up to
+// maxPoints. Bins are per window length: bin k is k cycles across [a, b], so
+// n samples of the window resolve bins up to n / 2 and everything above folds
+// back onto them. Non-finite samples (poles, log of 0) are masked out.
+class BandwidthProbe {
+public:
+    // Starts over only when signalId, the window or tol change. Otherwise an
+    // estimate stopped by maxPoints continues from the grid it has once
+    // maxPoints allows more. interrupted() is polled after each grid level:
+    // when it returns true that level is dropped and the previous estimate
+    // kept, to be refined on a later call.
+    void estimate(const std::function<double(double)>& f, unsigned long long signalId,
+        double a, double b, double tol, int maxPoints, const std::function<bool()>& interrupted);
+    void clear();
+
+    // an estimate exists (fewer than two finite samples give none)
+    bool valid() const { return valid_; }
+    // false while the spectrum had not decayed at the current grid (bandwidth is a lower bound)
+    bool resolved() const { return resolved_; }
+    int points() const { return points_; }
+    // highest bin that matters, and the same as rad per x unit
+    int bandwidthBins() const { return band_; }
+    double bandwidth() const;
+
+    // relative RMS error folded back by sampling the window with n points
+    double aliasError(int n) const;
+    // smallest 2^i 3^j 5^k >= n, sizes the mixed-radix FFT handles directly
+    static int smoothSize(int n);
+    // smallest FFT-friendly n in [minN, maxN] whose aliasError is <= tol (maxN if none)
+    int spectrumSize(double tol, int minN, int maxN) const;
+
+private:
+    void update();
+
+    unsigned long long signalId_ = ~0ull;
+    double a_ = 0.0, b_ = 0.0, tol_ = -1.0;
+    bool valid_ = false;
+    bool resolved_ = false;
+    int points_ = 0;
+    int band_ = 0;
+    // samples at a + i (b - a) / points_, i = 0..points_, and on the check
+    // grid of 3 / 4 the density; empty until the first level is complete
+    std::vector<double> x_, check_;
+    std::vector<double> tail_;    // tail_[k]: fraction of the energy in bins >= k
+};
+
+// Sample counts picked by the auto-N mode for the current view
+struct AutoSamples {
+    bool active = false;          // auto-N on and both probes valid
+    int curveN = 0;               // plotted range: bandwidth-bound, at most one sample per pixel
+    int spectrumN = 0;            // transform window: smallest alias-free FFT-friendly size
+    double curveAlias = 0.0;      // estimated relative RMS aliasing error at those sizes
+    double spectrumAlias = 0.0;
+    double curveBandwidth = 0.0;  // rad per x unit
+    double spectrumBandwidth = 0.0;
+    bool resolved = true;         // both coarse spectra decayed before their top bin
+};
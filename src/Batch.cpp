@@ -0,0 +1,236 @@
+#include "Batch.h"
+#include "Config.h"
+#include "Scene.h"
+#include "PlotExport.h"
+#include "Timing.h"
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cstring>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <set>
+#include <algorithm>
+#include <filesystem>
+
+using Clock = std::chrono::steady_clock;
+
+static bool ParseFloat(const std::string& s, float& v) {
+    std::istringstream iss(s);
+    return (iss >> v) && (iss >> std::ws).eof();
+}
+
+static bool ValidName(const std::string& s) {
+    if (s.empty()) return false;
+    for (unsigned char c : s)
+        if (!std::isalnum(c) && c != '_' && c != '-' && c != '.') return false;
+    return true;
+}
+
+bool LoadManifest(const std::string& path, std::vector<BatchJob>& jobs, std::string& error) {
+    std::ifstream f(path);
+    if (!f.is_open()) { error = "Cannot open manifest " + path; return false; }
+
+    static const char* const numeric[] = { "samples", "center", "range", "t", "a", "b", "c", "d" };
+    std::set<std::string> names;
+    std::string line;
+    for (int lineNo = 1; std::getline(f, line); ++lineNo) {
+        std::istringstream iss(line);
+        BatchJob job;
+        job.line = lineNo;
+        if (!(iss >> job.name) || job.name[0] == '#') continue;
+
+        auto fail = [&](const std::string& what) {
+            error = path + ":" + std::to_string(lineNo) + ": " + what;
+            return false;
+        };
+        if (!ValidName(job.name)) return fail("job name '" + job.name + "' is not a valid file name");
+        if (!names.insert(job.name).second) return fail("duplicate job name '" + job.name + "'");
+
+        std::string tok;
+        while (iss >> tok) {
+            const size_t eq = tok.find('=');
+            if (eq == std::string::npos) return fail("expected key=value, got '" + tok + "'");
+            const std::string key = tok.substr(0, eq);
+            std::string value = tok.substr(eq + 1);
+            if (key == "expr") {
+                // the expression may contain spaces: take the rest of the line
+                std::string rest;
+                std::getline(iss, rest);
+                value += rest;
+                if (value.empty()) return fail("empty expr");
+                job.overrides.emplace_back(key, value);
+                break;
+            }
+            if (key == "config") { job.config = value; continue; }
+            float v;
+            if (key == "xmin" || key == "xmax") {
+                if (!ParseFloat(value, v)) return fail("bad number for " + key);
+                (key == "xmin" ? job.xMin : job.xMax) = v;
+                continue;
+            }
+            const bool known = std::find(std::begin(numeric), std::end(numeric), key) != std::end(numeric);
+            if (!known) return fail("unknown key '" + key + "'");
+            if (!ParseFloat(value, v)) return fail("bad number for " + key);
+            job.overrides.emplace_back(key, value);
+        }
+        if (!(job.xMax > job.xMin)) return fail("xmax must be greater than xmin");
+        jobs.push_back(std::move(job));
+    }
+    return true;
+}
+
+static void ApplyOverride(AppConfig& cfg, const std::string& key, const std::string& value) {
+    if (key == "expr") {
+        std::strncpy(cfg.funcExpr, value.c_str(), AppConfig::kExprBufSize - 1);
+        cfg.funcExpr[AppConfig::kExprBufSize - 1] = '\0';
+        return;
+    }
+    float v = 0.0f;
+    ParseFloat(value, v);   // validated by LoadManifest
+    if (key == "samples") cfg.samples = std::max(2, (int)v);
+    else if (key == "center") cfg.fourierCenter = v;
+    else if (key == "range") cfg.fourierRange = v;
+    else if (key == "t") cfg.time = v;
+    else if (key == "a") cfg.params[0] = v;
+    else if (key == "b") cfg.params[1] = v;
+    else if (key == "c") cfg.params[2] = v;
+    else if (key == "d") cfg.params[3] = v;
+}
+
+// Streams (a, b) pairs to one file. Binary layout, little-endian:
+//   char magic[4] = "FVB1", uint32 kind (0 curve, 1 spectrum), uint64 count,
+//   then count pairs of doubles: (x, y) for curves, (w, |F(w)|) for spectra.
+class PairWriter {
+public:
+    PairWriter(const std::string& path, int format, uint32_t kind, uint64_t count, const char* header)
+        : format_(format)
+    {
+        out_.rdbuf()->pubsetbuf(buffer_, sizeof(buffer_));   // before open() to take effect
+        out_.open(path, format == BATCH_BINARY ? std::ios::out | std::ios::binary : std::ios::out);
+        if (format_ == BATCH_BINARY) {
+            out_.write("FVB1", 4);
+            out_.write((const char*)&kind, sizeof(kind));
+            out_.write((const char*)&count, sizeof(count));
+        }
+        else out_ << header << "\n";
+    }
+
+    void put(double a, double b) {
+        if (format_ == BATCH_BINARY) {
+            const double ab[2] = { a, b };
+            out_.write((const char*)ab, sizeof(ab));
+            return;
+        }
+        char line[64];
+        const int n = std::snprintf(line, sizeof(line), "%.9g,%.17g\n", a, b);
+        out_.write(line, n);
+    }
+
+    bool ok() { out_.flush(); return (bool)out_; }
+
+private:
+    int format_;
+    char buffer_[1 << 16];
+    std::ofstream out_;
+};
+
+// ImGui keeps one current context per process, so plot images are drawn one
+// at a time; each still rasterizes its tiles in parallel
+static std::mutex g_pngMutex;
+
+static BatchResult RunJob(const BatchJob& job, const BatchOptions& opt, Scene& scene) {
+    BatchResult r;
+    r.name = job.name;
+    const auto t0 = Clock::now();
+
+    AppConfig cfg;
+    if (!job.config.empty() && !cfg.Load(job.config.c_str(), scene)) {
+        r.error = "cannot read config " + job.config;
+        return r;
+    }
+    for (const auto& kv : job.overrides) ApplyOverride(cfg, kv.first, kv.second);
+    cfg.evalBudgetMs = opt.budgetMs;
+    cfg.chebProxy = false;   // exports are exact samples of f
+
+    scene.SetExpression(cfg.funcExpr);
+    scene.FinishCompiling();
+    r.compileMs = MsSince(t0);
+    if (scene.HasError()) {
+        r.error = scene.GetLastError();
+        while (!r.error.empty() && r.error.back() == '\n') r.error.pop_back();
+        return r;
+    }
+
+    const int N = std::max(2, cfg.samples);
+    r.samples = N;
+    const std::string stem = (std::filesystem::path(opt.outDir) / job.name).string();
+    const char* ext = opt.format == BATCH_BINARY ? ".bin" : ".csv";
+
+    if (opt.curves) {
+        const auto t1 = Clock::now();
+        const std::vector<double> ys = scene.SampleFunction(cfg, job.xMin, job.xMax, N);
+        r.aborted |= scene.WasAborted();
+        PairWriter w(stem + ".curve" + ext, opt.format, 0, (uint64_t)ys.size(), "x,y");
+        for (int i = 0; i < (int)ys.size(); ++i) {
+            // same grid as the sampler
+            const float t = float(i) / float(N - 1);
+            w.put(job.xMin + t * (job.xMax - job.xMin), ys[i]);
+        }
+        if (!w.ok()) { r.error = "cannot write " + stem + ".curve" + ext; return r; }
+        r.curveMs = MsSince(t1);
+    }
+    if (opt.spectra) {
+        const auto t1 = Clock::now();
+        const FourierSpectrum spec = scene.ComputeSpectrum(cfg, N);
+        r.aborted |= scene.WasAborted();
+        const size_t n = std::min(spec.freqs.size(), spec.magn.size());
+        PairWriter w(stem + ".spectrum" + ext, opt.format, 1, (uint64_t)n, "w,magn");
+        for (size_t k = 0; k < n; ++k) w.put(spec.freqs[k], spec.magn[k]);
+        if (!w.ok()) { r.error = "cannot write " + stem + ".spectrum" + ext; return r; }
+        r.spectrumMs = MsSince(t1);
+    }
+    if (opt.pngWidth > 0) {
+        std::lock_guard<std::mutex> lock(g_pngMutex);
+        const auto t1 = Clock::now();
+        std::string error;
+        if (!ExportPlotPng(scene, cfg, ImVec2(1280.0f, 720.0f), opt.pngWidth, stem + ".png", error)) {
+            r.error = error;
+            return r;
+        }
+        r.pngMs = MsSince(t1);
+    }
+    r.ok = true;
+    return r;
+}
+
+std::vector<BatchResult> RunBatch(const std::vector<BatchJob>& jobs, const BatchOptions& opt) {
+    std::vector<BatchResult> results(jobs.size());
+    if (jobs.empty()) return results;
+
+    std::error_code ec;
+    std::filesystem::create_directories(opt.outDir, ec);
+
+    int threads = opt.threads > 0 ? opt.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, (int)jobs.size());
+
+    // one Scene per worker: its compiled programs and caches carry over between jobs
+    std::atomic<int> next{ 0 };
+    auto worker = [&] {
+        Scene scene;
+        for (int i = next++; i < (int)jobs.size(); i = next++) {
+            const auto t0 = Clock::now();
+            results[i] = RunJob(jobs[i], opt, scene);
+            results[i].totalMs = MsSince(t0);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+    return results;
+}
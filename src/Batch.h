@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <utility>
+
+// One manifest line: an expression and how to sample it.
+// Manifest syntax, one job per line ('#' starts a comment):
+//   <name> [config=<file>] [key=value ...] [expr=<rest of the line>]
+// keys: samples, xmin, xmax, center, range, t, a, b, c, d
+struct BatchJob {
+    std::string name;      // output file stem: letters, digits, '_', '-', '.'
+    std::string config;    // optional config file loaded with AppConfig::Load first
+    std::vector<std::pair<std::string, std::string>> overrides;   // applied on top, in order
+    float xMin = -10.0f, xMax = 10.0f;   // curve range
+    int line = 0;
+};
+
+enum BatchFormat {
+    BATCH_CSV = 0,      // "x,y" rows
+    BATCH_BINARY,       // header + interleaved little-endian doubles (see Batch.cpp)
+};
+
+struct BatchOptions {
+    std::string outDir = ".";
+    int   format = BATCH_CSV;
+    int   threads = 0;            // 0 = one per hardware thread
+    bool  curves = true;
+    bool  spectra = true;
+    float budgetMs = 60000.0f;    // per pass; much looser than interactive use
+    int   pngWidth = 0;           // > 0: also render <name>.png this wide (1280x720 view)
+};
+
+struct BatchResult {
+    std::string name;
+    bool ok = false;
+    std::string error;
+    bool aborted = false;         // a pass hit the budget, output holds NaN from there on
+    int samples = 0;
+    double compileMs = 0.0, curveMs = 0.0, spectrumMs = 0.0, pngMs = 0.0, totalMs = 0.0;
+};
+
+// Parse a manifest; on failure `error` names the offending line
+bool LoadManifest(const std::string& path, std::vector<BatchJob>& jobs, std::string& error);
+
+// Run every job on worker threads (one Scene each), streaming
+// <outDir>/<name>.curve.{csv,bin}, <name>.spectrum.{csv,bin} and <name>.png.
+// Results keep manifest order.
+std::vector<BatchResult> RunBatch(const std::vector<BatchJob>& jobs, const BatchOptions& opt);
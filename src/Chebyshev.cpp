@@ -0,0 +1,151 @@
+#include "Chebyshev.h"
+#include "FFT.h"
+#include "ThreadPool.h"
+#include <cmath>
+#include <algorithm>
+
+static const double kPi = 3.14159265358979323846;
+
+// DCT-I through an FFT of the even extension v_0..v_n, v_{n-1}..v_1
+std::vector<double> chebCoefficients(const std::vector<double>& values) {
+    const int n = (int)values.size() - 1;
+    if (n < 1) return values;
+    std::vector<FFT::cplx> ext(2 * n);
+    for (int j = 0; j <= n; ++j) ext[j] = values[j];
+    for (int j = 1; j < n; ++j) ext[2 * n - j] = values[j];
+    FFT(2 * n).forward(ext);
+
+    std::vector<double> c(n + 1);
+    for (int k = 0; k <= n; ++k) c[k] = ext[k].real() / n;
+    c[0] *= 0.5;
+    c[n] *= 0.5;
+    return c;
+}
+
+static double clenshaw(const std::vector<double>& c, double t) {
+    double b1 = 0.0, b2 = 0.0;
+    for (int k = (int)c.size() - 1; k >= 1; --k) {
+        const double tmp = 2.0 * t * b1 - b2 + c[k];
+        b2 = b1;
+        b1 = tmp;
+    }
+    return t * b1 - b2 + (c.empty() ? 0.0 : c[0]);
+}
+
+void ChebProxy::clear() {
+    pieces_.clear();
+    spectrum_.clear();
+    converged_ = false;
+    evals_ = 0;
+}
+
+void ChebProxy::fit(const std::function<double(int, double)>& f, int slots, double a, double b,
+    double tol, int maxDegree, int maxPieces)
+{
+    clear();
+    if (!(b > a)) return;
+    f_ = &f;
+    slots_ = std::max(1, slots);
+    tol_ = tol;
+    maxDegree_ = std::max(16, maxDegree);
+    maxDepth_ = 0;
+    while ((2 << maxDepth_) <= maxPieces) ++maxDepth_;
+
+    converged_ = true;
+    fitPiece(a, b, 0);
+    f_ = nullptr;
+
+    // spectral estimate from the proxy itself
+    const int n = 256;
+    std::vector<double> vals(n + 1);
+    for (int j = 0; j <= n; ++j) {
+        const double x = 0.5 * (a + b) + 0.5 * (b - a) * std::cos(kPi * j / n);
+        const auto it = std::lower_bound(pieces_.begin(), pieces_.end(), x,
+            [](const Piece& p, double v) { return p.b < v; });
+        const Piece& p = it == pieces_.end() ? pieces_.back() : *it;
+        vals[j] = clenshaw(p.coeffs, (2.0 * x - p.a - p.b) / (p.b - p.a));
+    }
+    spectrum_ = chebCoefficients(vals);
+    for (double& c : spectrum_) c = std::fabs(c);
+}
+
+// Values at x_j = cos(pi j / n) mapped to [a, b]. With refine, vals holds the
+// n/2 + 1 previous samples, which are the even-indexed points of the new grid.
+void ChebProxy::sample(double a, double b, int n, std::vector<double>& vals, bool refine) {
+    std::vector<double> out(n + 1);
+    int step = 1;
+    if (refine) {
+        for (int j = 0; j <= n / 2; ++j) out[2 * j] = vals[j];
+        step = 2;
+    }
+    const int first = refine ? 1 : 0;
+    const int count = (n - first) / step + 1;
+    const int lanes = std::min(slots_, count);
+    const auto& f = *f_;
+    ThreadPool::Shared().parallelFor(0, lanes, [&](int lane) {
+        for (int i = lane; i < count; i += lanes) {
+            const int j = first + i * step;
+            out[j] = f(lane, 0.5 * (a + b) + 0.5 * (b - a) * std::cos(kPi * j / n));
+        }
+    });
+    evals_ += count;
+    vals.swap(out);
+}
+
+void ChebProxy::fitPiece(double a, double b, int depth) {
+    std::vector<double> vals;
+    std::vector<double> c;
+    int n = 16;
+    sample(a, b, n, vals, false);
+
+    for (;;) {
+        double scale = 0.0;
+        bool finite = true;
+        for (double v : vals) {
+            if (!std::isfinite(v)) { finite = false; break; }
+            scale = std::max(scale, std::fabs(v));
+        }
+        if (!finite) { c.clear(); break; }
+
+        c = chebCoefficients(vals);
+        // resolved when the last eighth of the series is below the noise floor
+        const double floor = tol_ * scale;
+        const int tail = std::max(2, n / 8);
+        bool resolved = true;
+        for (int k = n - tail; k <= n; ++k) if (std::fabs(c[k]) > floor) { resolved = false; break; }
+        if (resolved) {
+            int last = n;
+            while (last > 0 && std::fabs(c[last]) <= floor) --last;
+            c.resize(last + 1);
+            pieces_.push_back({ a, b, std::move(c), true });
+            return;
+        }
+        if (2 * n > maxDegree_) break;
+        n *= 2;
+        sample(a, b, n, vals, true);
+    }
+
+    if (depth < maxDepth_) {
+        const double m = 0.5 * (a + b);
+        fitPiece(a, m, depth + 1);
+        fitPiece(m, b, depth + 1);
+        return;
+    }
+    converged_ = false;
+    pieces_.push_back({ a, b, std::move(c), false });
+}
+
+bool ChebProxy::evaluate(double x, double& y) const {
+    if (pieces_.empty() || x < pieces_.front().a || x > pieces_.back().b) return false;
+    const auto it = std::lower_bound(pieces_.begin(), pieces_.end(), x,
+        [](const Piece& p, double v) { return p.b < v; });
+    if (it == pieces_.end() || !it->converged) return false;
+    y = clenshaw(it->coeffs, (2.0 * x - it->a - it->b) / (it->b - it->a));
+    return true;
+}
+
+int ChebProxy::maxDegree() const {
+    int d = 0;
+    for (const auto& p : pieces_) d = std::max(d, (int)p.coeffs.size() - 1);
+    return d;
+}
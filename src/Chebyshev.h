@@ -0,0 +1,55 @@
+#pragma once
+#include <vector>
+#include <functional>
+
+// Piecewise Chebyshev proxy of an expression (chebfun-style).
+// Each piece samples f at Chebyshev points of 17, 33, 65, ... nodes (reusing
+// the previous samples), turns them into coefficients with a DCT and stops
+// once the tail coefficients drop below tol relative to the largest |f|.
+// Pieces that do not resolve by maxDegree are bisected. Afterwards every
+// evaluation is a Clenshaw recurrence instead of a run of the expression.
+class ChebProxy {
+public:
+    struct Piece {
+        double a = 0.0, b = 0.0;
+        std::vector<double> coeffs;     // T_0 .. T_n on [a, b]
+        bool converged = false;
+    };
+
+    // f(slot, x) gets a distinct slot per concurrent lane
+    void fit(const std::function<double(int, double)>& f, int slots, double a, double b,
+        double tol, int maxDegree = 128, int maxPieces = 32);
+    void clear();
+
+    bool valid() const { return !pieces_.empty(); }
+    // true when every piece resolved f to tol
+    bool converged() const { return converged_; }
+
+    // Clenshaw evaluation; false outside [a, b] or on a piece that did not converge
+    bool evaluate(double x, double& y) const;
+
+    const std::vector<Piece>& pieces() const { return pieces_; }
+    int maxDegree() const;
+    long evals() const { return evals_; }
+
+    // |c_k| of a degree-256 Chebyshev series over the whole domain, computed
+    // by DCT from proxy values: a cheap spectral estimate of f (no f calls)
+    const std::vector<double>& spectrum() const { return spectrum_; }
+
+private:
+    void fitPiece(double a, double b, int depth);
+    void sample(double a, double b, int n, std::vector<double>& vals, bool refine);
+
+    const std::function<double(int, double)>* f_ = nullptr;
+    int slots_ = 1;
+    double tol_ = 0.0;
+    int maxDegree_ = 128, maxDepth_ = 5;
+
+    std::vector<Piece> pieces_;
+    bool converged_ = false;
+    long evals_ = 0;
+    std::vector<double> spectrum_;
+};
+
+// Chebyshev coefficients of the interpolant through v_j = f(cos(pi j / n)), j = 0..n
+std::vector<double> chebCoefficients(const std::vector<double>& values);
@@ -0,0 +1,93 @@
+#include "ColumnEval.h"
+#include "ThreadPool.h"
+#include <algorithm>
+
+void ColumnEval::bind(const ExprTree* tree, int xVar, int varCount) {
+    tree_ = tree;
+    xVar_ = xVar;
+    vars_.assign(varCount, 0.0);
+    cols_.clear();
+    if (tree_) cols_.resize(tree_->nodes().size());
+    dirty_ = ~0u;
+}
+
+void ColumnEval::setGrid(double xMin, double xMax, int n) {
+    if (xMin == xMin_ && xMax == xMax_ && n == n_) return;
+    xMin_ = xMin;
+    xMax_ = xMax;
+    n_ = n;
+    dirty_ |= 1u << xVar_;
+}
+
+void ColumnEval::setVar(int var, double value) {
+    if (vars_[var] == value) return;
+    vars_[var] = value;
+    dirty_ |= 1u << var;
+}
+
+const std::vector<double>& ColumnEval::evaluate() {
+    out_.resize(std::max(n_, 0));
+    recomputed_ = 0;
+    if (!tree_ || !tree_->valid() || n_ <= 0) {
+        std::fill(out_.begin(), out_.end(), 0.0);
+        return out_;
+    }
+
+    const auto& nodes = tree_->nodes();
+    const uint32_t xBit = 1u << xVar_;
+
+    // pick the stale nodes; a node without a column yet is always stale
+    std::vector<int> scalars, columns;
+    for (int i = 0; i < (int)nodes.size(); ++i) {
+        const uint32_t m = tree_->mask(i);
+        const bool stale = cols_[i].empty() || (m & dirty_);
+        if (!stale) continue;
+        if (m & xBit) columns.push_back(i);
+        else scalars.push_back(i);
+    }
+    recomputed_ = int(scalars.size() + columns.size());
+
+    auto value = [&](int i, int k) { return cols_[i].size() == 1 ? cols_[i][0] : cols_[i][k]; };
+
+    for (int i : scalars) {
+        const ExprTree::Node& n = nodes[i];
+        double v;
+        if (n.op == ExprTree::OP_CONST) v = n.value;
+        else if (n.op == ExprTree::OP_VAR) v = vars_[n.var];
+        else v = tree_->apply<double>(n, value(n.a, 0), n.b >= 0 ? value(n.b, 0) : 0.0);
+        cols_[i].assign(1, v);
+    }
+    for (int i : columns) cols_[i].resize(n_);
+
+    // chunks of samples run all stale columns back to back while the data is in cache
+    const double dx = n_ > 1 ? (xMax_ - xMin_) / (n_ - 1) : 0.0;
+    const int kChunk = 1024;
+    const int chunks = (n_ + kChunk - 1) / kChunk;
+    if (!columns.empty()) {
+        ThreadPool::Shared().parallelFor(0, chunks, [&](int c) {
+            const int lo = c * kChunk, hi = std::min(n_, lo + kChunk);
+            for (int i : columns) {
+                const ExprTree::Node& n = nodes[i];
+                std::vector<double>& col = cols_[i];
+                if (n.op == ExprTree::OP_VAR) {
+                    for (int k = lo; k < hi; ++k) col[k] = xMin_ + k * dx;
+                    continue;
+                }
+                const std::vector<double>& a = cols_[n.a];
+                const std::vector<double>* b = n.b >= 0 ? &cols_[n.b] : nullptr;
+                const bool sa = a.size() == 1, sb = !b || b->size() == 1;
+                for (int k = lo; k < hi; ++k) {
+                    const double va = sa ? a[0] : a[k];
+                    const double vb = b ? (sb ? (*b)[0] : (*b)[k]) : 0.0;
+                    col[k] = tree_->apply<double>(n, va, vb);
+                }
+            }
+        });
+    }
+    dirty_ = 0;
+
+    const int root = tree_->root();
+    if (cols_[root].size() == 1) std::fill(out_.begin(), out_.end(), cols_[root][0]);
+    else std::copy(cols_[root].begin(), cols_[root].end(), out_.begin());
+    return out_;
+}
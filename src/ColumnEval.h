@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "ExprTree.h"
+
+// Evaluates an ExprTree over a uniform x grid one node at a time, keeping a
+// column of results per node. Nodes that do not depend on x hold a single
+// value. Changing a variable only marks the nodes whose dependency mask
+// contains it, so for exp(-x^2) * sin(x - t) an animated t recomputes
+// x - t, the sine and the product while exp(-x^2) stays cached.
+class ColumnEval {
+public:
+    // Attach a parsed tree; xVar is the index of the grid variable. Clears all columns.
+    void bind(const ExprTree* tree, int xVar, int varCount);
+    void setGrid(double xMin, double xMax, int n);
+    void setVar(int var, double value);
+
+    // Column of the root node, always n values
+    const std::vector<double>& evaluate();
+
+    // Nodes recomputed by the last evaluate() and the total node count
+    int recomputed() const { return recomputed_; }
+    int nodes() const { return tree_ ? (int)tree_->nodes().size() : 0; }
+
+private:
+    const ExprTree* tree_ = nullptr;
+    int xVar_ = 0;
+    std::vector<double> vars_;
+    double xMin_ = 0.0, xMax_ = 0.0;
+    int n_ = 0;
+
+    uint32_t dirty_ = ~0u;
+    std::vector<std::vector<double>> cols_;
+    std::vector<double> out_;
+    int recomputed_ = 0;
+};
@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <exprtk.hpp>
+
+// Variables visible in f: x is the plot axis, t the animation clock,
+// a..d user parameters driven by sliders
+static const char* const kVarNames[] = { "x", "t", "a", "b", "c", "d" };
+static const int kVarCount = 6;
+
+// One compiled copy of an expression bound to its own x variable.
+// exprtk evaluates through the bound variable, so every thread needs its own copy.
+// t and the parameters are shared by all copies of one program and only written
+// between passes.
+struct CompiledExpr {
+    using symbol_table_t = exprtk::symbol_table<float>;
+    using expression_t = exprtk::expression<float>;
+    using parser_t = exprtk::parser<float>;
+
+    symbol_table_t symbols;
+    expression_t   expression;
+    float x = 0.0f;
+
+    explicit CompiledExpr(float* shared) {
+        symbols.add_variable("x", x);
+        for (int i = 1; i < kVarCount; ++i) symbols.add_variable(kVarNames[i], shared[i - 1]);
+        symbols.add_constants();
+        expression.register_symbol_table(symbols);
+    }
+
+    float Eval(float v) {
+        x = v;
+        return expression.value();
+    }
+};
+
+// Deadline shared by every compiled copy. exprtk calls check() on each loop
+// iteration, so a runaway loop stops once the pass is over budget, and
+// Scene::Eval polls the same deadline between samples. Nothing throws: the
+// pass is marked tripped and the remaining samples come back as NaN.
+// A thread can run under its own deadline (background profiling) without
+// touching the state of the drawing pass.
+struct EvalGuard : exprtk::loop_runtime_check {
+    using Clock = std::chrono::steady_clock;
+
+    std::atomic<long long> deadline{ 0 };   // Clock ticks, 0 = unlimited
+    std::atomic<bool> tripped{ false };
+
+    struct Local {
+        long long deadline = 0;
+        bool tripped = false;
+    };
+    static Local& ThisThread() {
+        thread_local Local local;
+        return local;
+    }
+
+    EvalGuard() {
+        loop_set = loop_runtime_check::e_all_loops;
+        max_loop_iterations = 10000000;
+    }
+
+    static long long Ticks(double msFromNow) {
+        const auto d = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::milli>(msFromNow));
+        return d.time_since_epoch().count();
+    }
+
+    void Arm(double ms) {
+        deadline = Ticks(ms);
+        tripped = false;
+    }
+    void Disarm() { deadline = 0; }
+    bool Expired() const {
+        const Local& local = ThisThread();
+        const long long d = local.deadline ? local.deadline : deadline.load();
+        return d != 0 && Clock::now().time_since_epoch().count() > d;
+    }
+    void Trip() {
+        Local& local = ThisThread();
+        if (local.deadline) local.tripped = true;
+        else tripped = true;
+    }
+
+    bool check() override {
+        if (!Expired()) return true;
+        Trip();
+        return false;
+    }
+    void handle_runtime_violation(const violation_context&) override { Trip(); }
+};
@@ -29,7 +29,117 @@ static inline bool read_vec4(std::istream& is, ImVec4& c) {
     return static_cast<bool>(is >> c.x >> c.y >> c.z >> c.w);
 }
 
+static inline void copy_expr(char* dst, int size, const std::string& src) {
+#ifdef _MSC_VER
+    strncpy_s(dst, size, src.c_str(), _TRUNCATE);
+#else
+    std::strncpy(dst, src.c_str(), size - 1);
+    dst[size - 1] = '\0';
+#endif
+}
+
+// rest of the line after the key, without the separating space
+static inline std::string read_rest(std::istringstream& iss) {
+    std::string s; std::getline(iss, s);
+    if (!s.empty() && s[0] == ' ') s.erase(0, 1);
+    trim_inplace(s);
+    return s;
+}
+
 // ---------- Load ----------
+void AppConfig::ApplyKV(std::istream& f, Scene& scene) {
+    std::string line;
+    while (std::getline(f, line)) {
+        trim_inplace(line);
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream iss(line);
+        std::string key; iss >> key;
+
+        if (key == "funcColor") { read_vec4(iss, funcColor); }
+        else if (key == "gridColor") { read_vec4(iss, gridColor); }
+        else if (key == "axisColor") { read_vec4(iss, axisColor); }
+        else if (key == "backgroundColor") { read_vec4(iss, backgroundColor); }
+        else if (key == "quadColor") { read_vec4(iss, quadColor); }
+        else if (key == "quadBorderColor") { read_vec4(iss, quadBorderColor); }
+        else if (key == "fourierColor") { read_vec4(iss, fourierColor); }
+        else if (key == "fourierRangeColor") { read_vec4(iss, fourierRangeColor); }
+        else if (key == "filterColor") { read_vec4(iss, filterColor); }
+        else if (key == "reconColor") { read_vec4(iss, reconColor); }
+        else if (key == "hilbertColor") { read_vec4(iss, hilbertColor); }
+        else if (key == "annotationColor") { read_vec4(iss, annotationColor); }
+        else if (key == "derivColor1") { read_vec4(iss, derivColor1); }
+        else if (key == "derivColor2") { read_vec4(iss, derivColor2); }
+
+        else if (key == "samples") { iss >> samples; }
+        else if (key == "autoSamples") { parse_bool(iss, autoSamples); }
+        else if (key == "aliasTolerance") { iss >> aliasTolerance; }
+        else if (key == "gridSpacing") { iss >> gridSpacing; }
+        else if (key == "gridScale") { iss >> gridScale; }
+        else if (key == "intervalPlot") { parse_bool(iss, intervalPlot); }
+        else if (key == "chebProxy") { parse_bool(iss, chebProxy); }
+        else if (key == "evalBudgetMs") { iss >> evalBudgetMs; }
+        else if (key == "animate") { parse_bool(iss, animate); }
+        else if (key == "time") { iss >> time; }
+        else if (key == "timeSpeed") { iss >> timeSpeed; }
+        else if (key == "params") { iss >> params[0] >> params[1] >> params[2] >> params[3]; }
+        else if (key == "showDerivative1") { parse_bool(iss, showDerivative1); }
+        else if (key == "showDerivative2") { parse_bool(iss, showDerivative2); }
+        else if (key == "adaptiveCurve") { parse_bool(iss, adaptiveCurve); }
+
+        else if (key == "fourierFunction") { parse_bool(iss, fourierFunction); }
+        else if (key == "showFourierRange") { parse_bool(iss, showFourierRange); }
+        else if (key == "fourierCenter") { iss >> fourierCenter; }
+        else if (key == "fourierRange") { iss >> fourierRange; }
+        else if (key == "fourierMode") { iss >> fourierMode; }
+        else if (key == "fourierDisplayMode") { iss >> fourierDisplayMode; }
+        else if (key == "cwtWavelet") { iss >> cwtWavelet; }
+        else if (key == "cwtScales") { iss >> cwtScales; }
+        else if (key == "cwtFreqMin") { iss >> cwtFreqMin; }
+        else if (key == "cwtFreqMax") { iss >> cwtFreqMax; }
+        else if (key == "psdSegments") { iss >> psdSegments; }
+        else if (key == "psdOverlap") { iss >> psdOverlap; }
+        else if (key == "hilbertTrack") { iss >> hilbertTrack; }
+
+        else if (key == "filterEnabled") { parse_bool(iss, filterEnabled); }
+        else if (key == "filterType") { iss >> filterType; }
+        else if (key == "filterLow") { iss >> filterLow; }
+        else if (key == "filterHigh") { iss >> filterHigh; }
+        else if (key == "filterWidth") { iss >> filterWidth; }
+        else if (key == "showRoots") { parse_bool(iss, showRoots); }
+        else if (key == "showExtrema") { parse_bool(iss, showExtrema); }
+        else if (key == "showAsymptotes") { parse_bool(iss, showAsymptotes); }
+        else if (key == "quadEnabled") { parse_bool(iss, quadEnabled); }
+        else if (key == "quadA") { iss >> quadA; }
+        else if (key == "quadB") { iss >> quadB; }
+        else if (key == "reconEnabled") { parse_bool(iss, reconEnabled); }
+        else if (key == "reconTerms") { iss >> reconTerms; }
+        else if (key == "workspaceSnapshot") { parse_bool(iss, workspaceSnapshot); }
+        else if (key == "filterKernel") {
+            std::string expr = read_rest(iss);
+            if (!expr.empty()) copy_expr(filterKernel, kExprBufSize, expr);
+        }
+
+        else if (key == "layer") {
+            PlotLayer layer;
+            if (parse_bool(iss, layer.visible) && read_vec4(iss, layer.color) &&
+                (int)layers.size() < kMaxLayers) {
+                copy_expr(layer.expr, kExprBufSize, read_rest(iss));
+                layers.push_back(layer);
+            }
+        }
+
+        else if (key == "funcExpr") {
+            std::string expr = read_rest(iss);
+            if (!expr.empty()) {
+                copy_expr(funcExpr, kExprBufSize, expr);
+                scene.SetExpression(expr);
+            }
+        }
+        // unknown keys are ignored for forward compatibility
+    }
+}
+
 bool AppConfig::Load(const char* file, Scene& scene) {
     std::ifstream f(file);
     if (!f.is_open()) return false;
@@ -37,54 +147,11 @@ bool AppConfig::Load(const char* file, Scene& scene) {
     // peek first line
     std::string first;
     std::getline(f, first);
-    std::string line = first;
 
     if (starts_with(first, "AppConfig")) {
         // new KV format
-        while (true) {
-            if (!std::getline(f, line)) break;
-            trim_inplace(line);
-            if (line.empty() || line[0] == '#') continue;
-
-            std::istringstream iss(line);
-            std::string key; iss >> key;
-
-            if (key == "funcColor") { read_vec4(iss, funcColor); }
-            else if (key == "gridColor") { read_vec4(iss, gridColor); }
-            else if (key == "axisColor") { read_vec4(iss, axisColor); }
-            else if (key == "backgroundColor") { read_vec4(iss, backgroundColor); }
-            else if (key == "quadColor") { read_vec4(iss, quadColor); }
-            else if (key == "quadBorderColor") { read_vec4(iss, quadBorderColor); }
-            else if (key == "fourierColor") { read_vec4(iss, fourierColor); }
-            else if (key == "fourierRangeColor") { read_vec4(iss, fourierRangeColor); }
-
-            else if (key == "samples") { iss >> samples; }
-            else if (key == "gridSpacing") { iss >> gridSpacing; }
-            else if (key == "gridScale") { iss >> gridScale; }
-
-            else if (key == "fourierFunction") { parse_bool(iss, fourierFunction); }
-            else if (key == "showFourierRange") { parse_bool(iss, showFourierRange); }
-            else if (key == "fourierCenter") { iss >> fourierCenter; }
-            else if (key == "fourierRange") { iss >> fourierRange; }
-            else if (key == "fourierMode") { iss >> fourierMode; }
-            else if (key == "fourierDisplayMode") { iss >> fourierDisplayMode; }
-
-            else if (key == "funcExpr") {
-                std::string expr; std::getline(iss, expr);
-                if (!expr.empty() && expr[0] == ' ') expr.erase(0, 1);
-                trim_inplace(expr);
-                if (!expr.empty()) {
-#ifdef _MSC_VER
-                    strncpy_s(funcExpr, kExprBufSize, expr.c_str(), _TRUNCATE);
-#else
-                    std::strncpy(funcExpr, expr.c_str(), kExprBufSize - 1);
-                    funcExpr[kExprBufSize - 1] = '\0';
-#endif
-                    scene.SetExpression(expr);
-                }
-            }
-            // unknown keys are ignored for forward compatibility
-        }
+        layers.clear();
+        ApplyKV(f, scene);
         return true;
     }
 
@@ -105,12 +172,7 @@ bool AppConfig::Load(const char* file, Scene& scene) {
     std::string expr;
     std::getline(f, expr);
     if (!expr.empty()) {
-#ifdef _MSC_VER
-        strncpy_s(funcExpr, kExprBufSize, expr.c_str(), _TRUNCATE);
-#else
-        std::strncpy(funcExpr, expr.c_str(), kExprBufSize - 1);
-        funcExpr[kExprBufSize - 1] = '\0';
-#endif
+        copy_expr(funcExpr, kExprBufSize, expr);
         scene.SetExpression(expr);
     }
 
@@ -123,7 +185,10 @@ bool AppConfig::Load(const char* file, Scene& scene) {
 void AppConfig::Save(const char* file) const {
     std::ofstream f(file);
     if (!f.is_open()) return;
+    Write(f);
+}
 
+void AppConfig::Write(std::ostream& f) const {
     f << "AppConfig v2\n";
     f.setf(std::ios::fixed);
     f << std::setprecision(6);
@@ -140,10 +205,28 @@ void AppConfig::Save(const char* file) const {
     dump4("quadBorderColor", quadBorderColor);
     dump4("fourierColor", fourierColor);
     dump4("fourierRangeColor", fourierRangeColor);
+    dump4("filterColor", filterColor);
+    dump4("reconColor", reconColor);
+    dump4("hilbertColor", hilbertColor);
+    dump4("annotationColor", annotationColor);
+    dump4("derivColor1", derivColor1);
+    dump4("derivColor2", derivColor2);
 
     f << "samples " << samples << "\n";
+    f << "autoSamples " << (autoSamples ? "true" : "false") << "\n";
+    f << "aliasTolerance " << aliasTolerance << "\n";
     f << "gridSpacing " << gridSpacing << "\n";
     f << "gridScale " << gridScale << "\n";
+    f << "intervalPlot " << (intervalPlot ? "true" : "false") << "\n";
+    f << "chebProxy " << (chebProxy ? "true" : "false") << "\n";
+    f << "evalBudgetMs " << evalBudgetMs << "\n";
+    f << "animate " << (animate ? "true" : "false") << "\n";
+    f << "time " << time << "\n";
+    f << "timeSpeed " << timeSpeed << "\n";
+    f << "params " << params[0] << " " << params[1] << " " << params[2] << " " << params[3] << "\n";
+    f << "showDerivative1 " << (showDerivative1 ? "true" : "false") << "\n";
+    f << "showDerivative2 " << (showDerivative2 ? "true" : "false") << "\n";
+    f << "adaptiveCurve " << (adaptiveCurve ? "true" : "false") << "\n";
 
     f << "fourierFunction " << (fourierFunction ? "true" : "false") << "\n";
     f << "showFourierRange " << (showFourierRange ? "true" : "false") << "\n";
@@ -151,6 +234,39 @@ void AppConfig::Save(const char* file) const {
     f << "fourierRange " << fourierRange << "\n";
     f << "fourierMode " << fourierMode << "\n";
     f << "fourierDisplayMode " << fourierDisplayMode << "\n";
+    f << "cwtWavelet " << cwtWavelet << "\n";
+    f << "cwtScales " << cwtScales << "\n";
+    f << "cwtFreqMin " << cwtFreqMin << "\n";
+    f << "cwtFreqMax " << cwtFreqMax << "\n";
+    f << "psdSegments " << psdSegments << "\n";
+    f << "psdOverlap " << psdOverlap << "\n";
+    f << "hilbertTrack " << hilbertTrack << "\n";
+
+    f << "filterEnabled " << (filterEnabled ? "true" : "false") << "\n";
+    f << "filterType " << filterType << "\n";
+    f << "filterLow " << filterLow << "\n";
+    f << "filterHigh " << filterHigh << "\n";
+    f << "filterWidth " << filterWidth << "\n";
+    f << "filterKernel " << filterKernel << "\n";
+
+    f << "showRoots " << (showRoots ? "true" : "false") << "\n";
+    f << "showExtrema " << (showExtrema ? "true" : "false") << "\n";
+    f << "showAsymptotes " << (showAsymptotes ? "true" : "false") << "\n";
+
+    f << "quadEnabled " << (quadEnabled ? "true" : "false") << "\n";
+    f << "quadA " << quadA << "\n";
+    f << "quadB " << quadB << "\n";
+
+    f << "reconEnabled " << (reconEnabled ? "true" : "false") << "\n";
+    f << "reconTerms " << reconTerms << "\n";
+    f << "workspaceSnapshot " << (workspaceSnapshot ? "true" : "false") << "\n";
+
+    // layer <visible> <r g b a> <expr>, expr is the rest of the line
+    for (const PlotLayer& layer : layers) {
+        f << "layer " << (layer.visible ? "true" : "false") << " "
+            << layer.color.x << " " << layer.color.y << " " << layer.color.z << " " << layer.color.w
+            << " " << layer.expr << "\n";
+    }
 
     // expr — остаток строки, без кавычек
     f << "funcExpr " << funcExpr << "\n";
@@ -1,13 +1,28 @@
 #pragma once
 #include <imgui/imgui.h>
 #include <string>
+#include <vector>
+#include <iosfwd>
 #include "Fourier.h"
+#include "Filter.h"
+#include "Wavelet.h"
+#include "Hilbert.h"
 
 class Scene;
 
 enum FourierDisplay {
     FOURIER_TRANSFORM = 0,
     FOURIER_MODULATED_SIGNAL,
+    FOURIER_SCALOGRAM,
+    FOURIER_PSD,
+    FOURIER_ANALYTIC,
+};
+
+// Extra function overlaid on f(x), sampled on the same grid
+struct PlotLayer {
+    char expr[512] = "";
+    ImVec4 color = ImVec4(0.5f, 0.5f, 0.5f, 1.0f);
+    bool visible = true;
 };
 
 struct AppConfig {
@@ -19,10 +34,36 @@ struct AppConfig {
     ImVec4 backgroundColor = ImVec4(1, 1, 1, 1);
     ImVec4 quadColor = ImVec4(1, 0, 1, 0.25f);
     ImVec4 quadBorderColor = ImVec4(0, 0, 1, 0.8f);
+    ImVec4 filterColor = ImVec4(0 / 255.f, 200 / 255.f, 120 / 255.f, 255 / 255.f);
+    ImVec4 derivColor1 = ImVec4(40 / 255.f, 120 / 255.f, 40 / 255.f, 255 / 255.f);
+    ImVec4 derivColor2 = ImVec4(150 / 255.f, 110 / 255.f, 30 / 255.f, 255 / 255.f);
+    ImVec4 annotationColor = ImVec4(220 / 255.f, 30 / 255.f, 30 / 255.f, 255 / 255.f);
+    ImVec4 reconColor = ImVec4(200 / 255.f, 60 / 255.f, 200 / 255.f, 255 / 255.f);
+    ImVec4 hilbertColor = ImVec4(120 / 255.f, 60 / 255.f, 220 / 255.f, 255 / 255.f);
 
     int   samples = 500;
+    // auto-N: sample counts from the bandwidth of f in view instead of samples,
+    // chosen so the estimated relative aliasing error stays under aliasTolerance
+    bool  autoSamples = false;
+    float aliasTolerance = 1e-3f;
+    float evalBudgetMs = 30.0f;   // per drawing pass; slower passes are cut short and N reduced
     int   gridSpacing = 50;
     int gridScale = 100;
+    // interval-arithmetic tracing of f(x): culls off-screen cells, breaks at poles
+    bool intervalPlot = false;
+    // serve f(x) from a piecewise Chebyshev fit of the plotted range
+    bool chebProxy = false;
+
+    // animation clock and slider parameters, visible in f(x) as t and a, b, c, d
+    bool  animate = false;
+    float time = 0.0f;
+    float timeSpeed = 1.0f;
+    float params[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+    // derivative layers and curvature-driven refinement of the f(x) polyline
+    bool showDerivative1 = false;
+    bool showDerivative2 = false;
+    bool adaptiveCurve = false;
 
     bool fourierFunction = false;
     bool showFourierRange = false;
@@ -31,8 +72,50 @@ struct AppConfig {
     int fourierMode = FOURIER_MAG;
     int fourierDisplayMode = FOURIER_TRANSFORM;
 
+    // scalogram (continuous wavelet transform), frequencies in rad/s
+    int   cwtWavelet = WAVELET_MORLET;
+    int   cwtScales = 64;
+    float cwtFreqMin = 0.5f;
+    float cwtFreqMax = 20.0f;
+
+    // power spectral density (Welch): segments averaged and the fraction each overlaps the next
+    int   psdSegments = 8;
+    float psdOverlap = 0.5f;
+
+    // analytic signal (Hilbert): envelope in fourierColor, phase or frequency track in hilbertColor
+    int   hilbertTrack = HILBERT_FREQUENCY;
+
+    // filtering stage between sampling and drawing (cutoffs in rad/s, width in x units)
+    bool  filterEnabled = false;
+    int   filterType = FILTER_LOWPASS;
+    float filterLow = 1.0f;
+    float filterHigh = 10.0f;
+    float filterWidth = 2.0f;
+
+    // automatic markers for zeros, peaks and poles of funcExpr
+    bool showRoots = false;
+    bool showExtrema = false;
+    bool showAsymptotes = false;
+
+    // definite integral of funcExpr over [quadA, quadB], shaded with quadColor/quadBorderColor
+    bool  quadEnabled = false;
+    float quadA = 0.0f;
+    float quadB = 1.0f;
+
+    // partial Fourier series overlay from the K strongest harmonics
+    bool reconEnabled = false;
+    int  reconTerms = 16;
+
+    // on exit, write workspace.fvs (config plus cached samples and spectrum) for a warm start
+    bool workspaceSnapshot = true;
+
+    // overlay layers drawn with f(x), at most kMaxLayers
+    static constexpr int kMaxLayers = 12;
+    std::vector<PlotLayer> layers;
+
     static constexpr int kExprBufSize = 512; 
     char funcExpr[512] = "x"; 
+    char filterKernel[512] = "exp(-x^2)";
 
     // helpers for ImGui::InputText
     char* funcExprBuf() { return funcExpr; }
@@ -41,4 +124,8 @@ struct AppConfig {
 
     bool Load(const char* file, Scene& scene);
     void Save(const char* file) const;
+    // config.ini text: Write emits the header and every key, ApplyKV reads
+    // "key value" lines on top of the current values (layer lines append)
+    void Write(std::ostream& os) const;
+    void ApplyKV(std::istream& is, Scene& scene);
 };
@@ -0,0 +1,75 @@
+#include "DrawBatch.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstring>
+
+void DrawBatch::begin(ImDrawList* target) {
+    target_ = target;
+    jobs_.clear();
+}
+
+void DrawBatch::add(Job job) {
+    jobs_.push_back(std::move(job));
+}
+
+void DrawBatch::addRange(int count, RangeJob job, int grain) {
+    if (count <= 0) return;
+    const int chunks = std::clamp(count / std::max(grain, 1), 1, (int)ThreadPool::Shared().concurrency());
+    for (int c = 0; c < chunks; ++c) {
+        const int b = int((long long)count * c / chunks);
+        const int e = int((long long)count * (c + 1) / chunks);
+        jobs_.push_back([job, b, e](ImDrawList* dl) { job(dl, b, e); });
+    }
+}
+
+// Appends the geometry of src to dst. Commands of src that share a VtxOffset
+// index one run of vertices; each run is copied with its indices rebased onto
+// dst's current vertex index. src must use dst's clip rect and texture.
+static void AppendList(ImDrawList* dst, const ImDrawList& src) {
+    const int cmds = src.CmdBuffer.Size;
+    for (int c = 0; c < cmds;) {
+        const unsigned vtxBegin = src.CmdBuffer[c].VtxOffset;
+        const unsigned idxBegin = src.CmdBuffer[c].IdxOffset;
+        unsigned idxEnd = idxBegin;
+        for (; c < cmds && src.CmdBuffer[c].VtxOffset == vtxBegin; ++c)
+            idxEnd = src.CmdBuffer[c].IdxOffset + src.CmdBuffer[c].ElemCount;
+        const unsigned vtxEnd = c < cmds ? src.CmdBuffer[c].VtxOffset : (unsigned)src.VtxBuffer.Size;
+        const int nv = int(vtxEnd - vtxBegin), ni = int(idxEnd - idxBegin);
+        if (ni == 0) continue;
+
+        dst->PrimReserve(ni, nv);
+        const unsigned base = dst->_VtxCurrentIdx;
+        std::memcpy(dst->_VtxWritePtr, src.VtxBuffer.Data + vtxBegin, nv * sizeof(ImDrawVert));
+        const ImDrawIdx* idx = src.IdxBuffer.Data + idxBegin;
+        for (int i = 0; i < ni; ++i) dst->_IdxWritePtr[i] = ImDrawIdx(base + idx[i]);
+        dst->_VtxWritePtr += nv;
+        dst->_IdxWritePtr += ni;
+        dst->_VtxCurrentIdx += nv;
+    }
+}
+
+void DrawBatch::flush() {
+    const int n = (int)jobs_.size();
+    if (n == 1) jobs_[0](target_);   // nothing to overlap with
+    if (n <= 1) {
+        jobs_.clear();
+        return;
+    }
+
+    while ((int)lists_.size() < n) lists_.push_back(std::make_unique<ImDrawList>(target_->_Data));
+    const ImVec2 clipMin = target_->GetClipRectMin(), clipMax = target_->GetClipRectMax();
+    for (int i = 0; i < n; ++i) {
+        // the lists outlive contexts (PNG export and replay run their own)
+        ImDrawList* dl = lists_[i].get();
+        dl->_Data = target_->_Data;
+        dl->_ResetForNewFrame();
+        dl->Flags = target_->Flags;
+        dl->_FringeScale = target_->_FringeScale;
+        dl->PushClipRect(clipMin, clipMax);
+        dl->PushTextureID(target_->_CmdHeader.TextureId);
+    }
+
+    ThreadPool::Shared().parallelFor(0, n, [&](int i) { jobs_[i](lists_[i].get()); });
+    for (int i = 0; i < n; ++i) AppendList(target_, *lists_[i]);
+    jobs_.clear();
+}
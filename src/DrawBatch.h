@@ -0,0 +1,29 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <vector>
+#include <imgui/imgui.h>
+
+// Geometry of independent plot layers, built on the shared ThreadPool.
+// Every job draws into a private ImDrawList; flush() appends those lists to
+// the target in the order the jobs were added, so the frame is the same as
+// drawing them one after the other. A job may only touch its own list and
+// data that stays unchanged until flush(): the ImGui context is not thread-safe.
+class DrawBatch {
+public:
+    using Job = std::function<void(ImDrawList*)>;
+    using RangeJob = std::function<void(ImDrawList*, int begin, int end)>;
+
+    // start collecting jobs for `target`, drawn with its current clip rect and texture
+    void begin(ImDrawList* target);
+    void add(Job job);
+    // items [0, count) split into contiguous chunks of at least `grain` items, one job each
+    void addRange(int count, RangeJob job, int grain = 2048);
+    // build every job and merge the lists into the target
+    void flush();
+
+private:
+    ImDrawList* target_ = nullptr;
+    std::vector<Job> jobs_;
+    std::vector<std::unique_ptr<ImDrawList>> lists_;   // kept across frames for their buffers
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include <cmath>
+
+// Second-order forward-mode dual number: value plus first and second
+// derivative with respect to one seed variable. Evaluating an ExprTree over
+// Dual2 yields f, f' and f'' in a single pass without finite differences.
+struct Dual2 {
+    double v = 0.0, d = 0.0, dd = 0.0;
+
+    Dual2() = default;
+    Dual2(double value) : v(value) {}
+    Dual2(double value, double d1, double d2) : v(value), d(d1), dd(d2) {}
+
+    static Dual2 Variable(double x) { return Dual2(x, 1.0, 0.0); }
+};
+
+// g(u) with g' and g'' known at u.v (chain rule to second order)
+inline Dual2 chain(const Dual2& u, double g, double g1, double g2) {
+    return Dual2(g, g1 * u.d, g2 * u.d * u.d + g1 * u.dd);
+}
+
+inline Dual2 operator-(const Dual2& a) { return Dual2(-a.v, -a.d, -a.dd); }
+inline Dual2 operator+(const Dual2& a, const Dual2& b) { return Dual2(a.v + b.v, a.d + b.d, a.dd + b.dd); }
+inline Dual2 operator-(const Dual2& a, const Dual2& b) { return Dual2(a.v - b.v, a.d - b.d, a.dd - b.dd); }
+inline Dual2 operator*(const Dual2& a, const Dual2& b) {
+    return Dual2(a.v * b.v, a.d * b.v + a.v * b.d, a.dd * b.v + 2.0 * a.d * b.d + a.v * b.dd);
+}
+inline Dual2 operator/(const Dual2& a, const Dual2& b) {
+    const double inv = 1.0 / b.v;
+    return a * chain(b, inv, -inv * inv, 2.0 * inv * inv * inv);
+}
+
+inline Dual2 sin(const Dual2& u) { const double s = std::sin(u.v), c = std::cos(u.v); return chain(u, s, c, -s); }
+inline Dual2 cos(const Dual2& u) { const double s = std::sin(u.v), c = std::cos(u.v); return chain(u, c, -s, -c); }
+inline Dual2 tan(const Dual2& u) {
+    const double t = std::tan(u.v), s2 = 1.0 + t * t;
+    return chain(u, t, s2, 2.0 * t * s2);
+}
+inline Dual2 asin(const Dual2& u) {
+    const double r = 1.0 / std::sqrt(1.0 - u.v * u.v);
+    return chain(u, std::asin(u.v), r, u.v * r * r * r);
+}
+inline Dual2 acos(const Dual2& u) {
+    const double r = 1.0 / std::sqrt(1.0 - u.v * u.v);
+    return chain(u, std::acos(u.v), -r, -u.v * r * r * r);
+}
+inline Dual2 atan(const Dual2& u) {
+    const double r = 1.0 / (1.0 + u.v * u.v);
+    return chain(u, std::atan(u.v), r, -2.0 * u.v * r * r);
+}
+inline Dual2 sinh(const Dual2& u) { const double s = std::sinh(u.v), c = std::cosh(u.v); return chain(u, s, c, s); }
+inline Dual2 cosh(const Dual2& u) { const double s = std::sinh(u.v), c = std::cosh(u.v); return chain(u, c, s, c); }
+inline Dual2 tanh(const Dual2& u) {
+    const double t = std::tanh(u.v), s2 = 1.0 - t * t;
+    return chain(u, t, s2, -2.0 * t * s2);
+}
+inline Dual2 exp(const Dual2& u) { const double e = std::exp(u.v); return chain(u, e, e, e); }
+inline Dual2 log(const Dual2& u) { const double r = 1.0 / u.v; return chain(u, std::log(u.v), r, -r * r); }
+inline Dual2 log10(const Dual2& u) { const double r = 1.0 / (u.v * std::log(10.0)); return chain(u, std::log10(u.v), r, -r / u.v); }
+inline Dual2 log2(const Dual2& u) { const double r = 1.0 / (u.v * std::log(2.0)); return chain(u, std::log2(u.v), r, -r / u.v); }
+inline Dual2 sqrt(const Dual2& u) {
+    const double s = std::sqrt(u.v);
+    return chain(u, s, 0.5 / s, -0.25 / (s * u.v));
+}
+inline Dual2 fabs(const Dual2& u) { const double sg = u.v < 0.0 ? -1.0 : 1.0; return chain(u, std::fabs(u.v), sg, 0.0); }
+inline Dual2 floor(const Dual2& u) { return Dual2(std::floor(u.v)); }
+inline Dual2 ceil(const Dual2& u) { return Dual2(std::ceil(u.v)); }
+inline Dual2 fmod(const Dual2& a, const Dual2& b) {
+    const double q = std::trunc(a.v / b.v);
+    return a - Dual2(q) * b;
+}
+inline Dual2 esgn(const Dual2& u) { return Dual2(u.v > 0.0 ? 1.0 : (u.v < 0.0 ? -1.0 : 0.0)); }
+inline Dual2 emin(const Dual2& a, const Dual2& b) { return a.v < b.v ? a : b; }
+inline Dual2 emax(const Dual2& a, const Dual2& b) { return a.v > b.v ? a : b; }
+inline Dual2 epowc(const Dual2& u, double c) {
+    if (c == 0.0) return Dual2(1.0);
+    // each term on its own: rebuilt from pow(u, c - 2), u = 0 with c < 2 gives inf * 0
+    const double d2 = c == 1.0 ? 0.0 : c * (c - 1.0) * std::pow(u.v, c - 2.0);
+    return chain(u, std::pow(u.v, c), c * std::pow(u.v, c - 1.0), d2);
+}
+inline Dual2 pow(const Dual2& a, const Dual2& b) { return exp(b * log(a)); }
@@ -0,0 +1,235 @@
+#include "ExprCache.h"
+#include "CompiledExpr.h"
+#include "ThreadPool.h"
+#include <cctype>
+#include <cmath>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+
+Program::Program() = default;
+Program::~Program() = default;   // CompiledExpr is complete here
+
+void Program::SetVars(const float* values) {
+    std::copy(values, values + vars_.size(), vars_.begin());
+}
+
+void Program::PrepareWorkers(int count) {
+    if (!valid) return;
+    CompiledExpr::parser_t parser;
+    parser.register_loop_runtime_check(*guard_);
+    while ((int)workers.size() < count) {
+        workers.push_back(std::make_unique<CompiledExpr>(vars_.data()));
+        parser.compile(source, workers.back()->expression);
+    }
+}
+
+void Program::VerifyTree(const double* vars) {
+    treeValid = valid && tree.valid();
+    if (!treeValid) return;
+    const double probes[] = { -2.3, -0.7, 0.3, 1.1, 2.9 };
+    double v[kVarCount];
+    std::copy(vars, vars + kVarCount, v);
+    for (double x : probes) {
+        v[0] = x;
+        const double a = tree.eval(v);
+        const double b = main->Eval((float)x);
+        const bool agree = std::isfinite(a) == std::isfinite(b) &&
+            (!std::isfinite(a) || std::fabs(a - b) <= 1e-4 * (1.0 + std::fabs(b)));
+        if (!agree) { treeValid = false; break; }
+    }
+}
+
+// Lexical size and loop keywords of the source
+static void ScanSource(const std::string& src, ExprProfile& p) {
+    for (size_t i = 0; i < src.size();) {
+        const unsigned char c = src[i];
+        if (std::isspace(c)) { ++i; continue; }
+        ++p.tokens;
+        if (std::isalpha(c) || c == '_') {
+            size_t j = i;
+            while (j < src.size() && (std::isalnum((unsigned char)src[j]) || src[j] == '_')) ++j;
+            std::string word = src.substr(i, j - i);
+            std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+            if (word == "for" || word == "while" || word == "repeat") p.loops = true;
+            i = j;
+        }
+        else if (std::isdigit(c) || c == '.') {
+            while (i < src.size() && (std::isalnum((unsigned char)src[i]) || src[i] == '.')) ++i;
+        }
+        else ++i;
+    }
+}
+
+ExprCache::ExprCache(float* shared, EvalGuard& guard, size_t capacity)
+    : shared_(shared), guard_(guard), capacity_(std::max<size_t>(capacity, 1))
+{
+    thread_ = std::thread([this] { CompileLoop(); });
+}
+
+ExprCache::~ExprCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+}
+
+std::string ExprCache::Normalize(const std::string& src) {
+    std::string out;
+    out.reserve(src.size());
+    bool quoted = false;
+    bool space = false;
+    for (char c : src) {
+        // whitespace separates tokens ("a or b" vs "aorb"), so a run keeps one space
+        if (!quoted && std::isspace((unsigned char)c)) { space = true; continue; }
+        if (space && !out.empty()) out += ' ';
+        space = false;
+        if (c == '\'') quoted = !quoted;
+        out += (quoted || c == '\'') ? c : (char)std::tolower((unsigned char)c);
+    }
+    return out;
+}
+
+std::shared_ptr<Program> ExprCache::Request(const std::string& src, int owner) {
+    const std::string key = Normalize(src);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        ++hits_;
+        return *it->second;
+    }
+    ++misses_;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // this owner stops waiting for its older text; a job nobody waits for is dropped
+        for (Job& j : queued_)
+            j.owners.erase(std::remove(j.owners.begin(), j.owners.end(), owner), j.owners.end());
+        queued_.erase(std::remove_if(queued_.begin(), queued_.end(),
+            [](const Job& j) { return j.owners.empty(); }), queued_.end());
+        if (key == compiling_) return nullptr;
+        auto it = std::find_if(queued_.begin(), queued_.end(), [&](const Job& j) { return j.key == key; });
+        if (it != queued_.end()) {
+            it->owners.push_back(owner);
+            return nullptr;
+        }
+        queued_.push_back({ { owner }, key, src, std::vector<float>(shared_, shared_ + kVarCount - 1) });
+    }
+    wake_.notify_one();
+    return nullptr;
+}
+
+std::vector<std::shared_ptr<Program>> ExprCache::Poll() {
+    std::vector<std::shared_ptr<Program>> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done.swap(done_);
+    }
+    for (const auto& p : done) Insert(p);
+    return done;
+}
+
+bool ExprCache::Busy() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !queued_.empty() || !compiling_.empty();
+}
+
+void ExprCache::Wait() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return queued_.empty() && compiling_.empty(); });
+}
+
+bool ExprCache::WaitFor(double timeoutMs) const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return idle_.wait_for(lock, std::chrono::duration<double, std::milli>(timeoutMs),
+        [this] { return queued_.empty() && compiling_.empty(); });
+}
+
+void ExprCache::Insert(const std::shared_ptr<Program>& p) {
+    auto it = index_.find(p->key);
+    if (it != index_.end()) {
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+    lru_.push_front(p);
+    index_[p->key] = lru_.begin();
+    while (lru_.size() > capacity_) {
+        index_.erase(lru_.back()->key);
+        lru_.pop_back();
+    }
+}
+
+void ExprCache::CompileLoop() {
+    for (;;) {
+        std::string src;
+        std::vector<float> vars;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stop_ || !queued_.empty(); });
+            if (stop_) return;
+            compiling_.swap(queued_.front().key);
+            src.swap(queued_.front().source);
+            vars.swap(queued_.front().vars);
+            queued_.pop_front();
+        }
+        auto p = Build(src, vars);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_.push_back(std::move(p));
+            compiling_.clear();
+        }
+        idle_.notify_all();
+    }
+}
+
+std::shared_ptr<Program> ExprCache::Build(const std::string& src, const std::vector<float>& vars) const {
+    auto p = std::make_shared<Program>();
+    p->source = src;
+    p->key = Normalize(src);
+    // the program's own t, a..d: the probe run below never touches what the UI thread writes
+    p->vars_ = vars;
+    p->guard_ = &guard_;
+    p->main = std::make_unique<CompiledExpr>(p->vars_.data());
+
+    CompiledExpr::parser_t parser;
+    parser.register_loop_runtime_check(guard_);
+    p->valid = parser.compile(src, p->main->expression);
+    if (!p->valid) {
+        std::ostringstream oss;
+        oss << "Parse error in expression: " << src << "\n";
+        for (std::size_t i = 0; i < parser.error_count(); ++i) {
+            auto e = parser.get_error(i);
+            oss << "Error " << i
+                << " at pos " << e.token.position
+                << " [" << exprtk::parser_error::to_str(e.mode)
+                << "] " << e.diagnostic << "\n";
+        }
+        p->error = oss.str();
+    }
+
+    ExprProfile& prof = p->profile;
+    ScanSource(src, prof);
+    if (p->valid) {
+        // timed probe run under this thread's own short deadline
+        const int kProbes = 16;
+        int done = 0;
+        EvalGuard::Local& local = EvalGuard::ThisThread();
+        local.deadline = EvalGuard::Ticks(20.0);
+        local.tripped = false;
+        const auto t0 = EvalGuard::Clock::now();
+        while (done < kProbes && !local.tripped && !guard_.Expired()) {
+            p->main->Eval(-3.0f + 6.0f * done / (kProbes - 1));
+            ++done;
+        }
+        const double us = std::chrono::duration<double, std::micro>(EvalGuard::Clock::now() - t0).count();
+        prof.aborted = local.tripped || done < kProbes;
+        prof.evalUs = us / std::max(done, 1);
+        local.deadline = 0;
+
+        p->tree.parse(src, std::vector<std::string>(kVarNames, kVarNames + kVarCount));
+        // one copy per pool slot, so installing never compiles on the UI thread
+        p->PrepareWorkers((int)ThreadPool::Shared().concurrency());
+    }
+    return p;
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <list>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <unordered_map>
+#include "ExprTree.h"
+
+struct CompiledExpr;
+struct EvalGuard;
+
+// Compile-time cost profile of an expression
+struct ExprProfile {
+    int    tokens = 0;        // lexical size of the source
+    bool   loops = false;     // contains for / while / repeat
+    double evalUs = 0.0;      // mean time of one evaluation over a few probe points
+    bool   aborted = false;   // the probe run hit its guard
+};
+
+// Everything derived from one source text: the exprtk compilation, the
+// expression tree, the cost profile and the per-thread copies.
+struct Program {
+    std::string source;
+    std::string key;          // normalized source
+    bool valid = false;
+    std::string error;
+
+    std::unique_ptr<CompiledExpr> main;
+    ExprTree tree;
+    bool treeValid = false;   // tree parsed and agrees with exprtk (see VerifyTree)
+    ExprProfile profile;
+    std::vector<std::unique_ptr<CompiledExpr>> workers;
+
+    Program();
+    ~Program();
+
+    // Make sure `count` per-thread copies exist, compiled on the calling thread.
+    // ExprCache builds one per thread pool slot on its compile thread, so the
+    // drawing passes only find them ready.
+    void PrepareWorkers(int count);
+    // Current t and a..d for every copy; UI thread, between passes
+    void SetVars(const float* values);
+    // Compare the tree with exprtk at a few points; vars holds the kVarNames values
+    void VerifyTree(const double* vars);
+
+private:
+    friend class ExprCache;
+    // t, a..d read by every copy; sized once before compiling, never reallocated
+    std::vector<float> vars_;
+    EvalGuard* guard_ = nullptr;
+};
+
+// LRU cache of compiled programs keyed by normalized source text. Sources not
+// in the cache are compiled on a background thread in request order. Each
+// request names its owner (an input field) and a queued source remembers every
+// owner waiting for it. An owner asking for newer text stops waiting for its
+// older one, and a source nobody waits for any more is dropped, so fast typing
+// compiles only the text that is current. Finished programs are handed back by Poll() on the UI
+// thread, which also files them in the cache.
+class ExprCache {
+public:
+    ExprCache(float* shared, EvalGuard& guard, size_t capacity = 32);
+    ~ExprCache();   // finishes the compile in progress, drops queued ones
+
+    ExprCache(const ExprCache&) = delete;
+    ExprCache& operator=(const ExprCache&) = delete;
+
+    // Whitespace runs collapsed to one space, ends trimmed and letters
+    // lowercased outside string literals
+    static std::string Normalize(const std::string& src);
+
+    // Cached program for src, or null after queueing its compilation
+    std::shared_ptr<Program> Request(const std::string& src, int owner = 0);
+    // Programs finished since the last call
+    std::vector<std::shared_ptr<Program>> Poll();
+
+    bool Busy() const;
+    // Block until nothing is queued or compiling (headless use)
+    void Wait() const;
+    // Same, for at most timeoutMs; true when idle
+    bool WaitFor(double timeoutMs) const;
+    size_t size() const { return lru_.size(); }
+    long hits() const { return hits_; }
+    long misses() const { return misses_; }
+
+private:
+    std::shared_ptr<Program> Build(const std::string& src, const std::vector<float>& vars) const;
+    void Insert(const std::shared_ptr<Program>& p);
+    void CompileLoop();
+
+    float* shared_;           // Scene's t, a..d; read on the UI thread when a compile is queued
+    EvalGuard& guard_;
+    size_t capacity_;
+
+    // UI thread only
+    std::list<std::shared_ptr<Program>> lru_;   // most recent first
+    std::unordered_map<std::string, std::list<std::shared_ptr<Program>>::iterator> index_;
+    long hits_ = 0, misses_ = 0;
+
+    // shared with the compile thread
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    mutable std::condition_variable idle_;
+    struct Job {
+        std::vector<int> owners;   // fields waiting for this source
+        std::string key, source;
+        std::vector<float> vars;   // t, a..d when it was queued
+    };
+    std::deque<Job> queued_;
+    std::string compiling_;   // normalized key, empty = none
+    std::vector<std::shared_ptr<Program>> done_;
+    bool stop_ = false;
+    std::thread thread_;
+};
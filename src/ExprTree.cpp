@@ -0,0 +1,187 @@
+#include "ExprTree.h"
+#include <cctype>
+#include <functional>
+#include <cstdlib>
+#include <limits>
+#include <algorithm>
+
+namespace {
+
+struct FuncInfo { const char* name; ExprTree::Op op; int args; };
+
+const FuncInfo kFuncs[] = {
+    { "sin", ExprTree::OP_SIN, 1 },   { "cos", ExprTree::OP_COS, 1 },   { "tan", ExprTree::OP_TAN, 1 },
+    { "asin", ExprTree::OP_ASIN, 1 }, { "acos", ExprTree::OP_ACOS, 1 }, { "atan", ExprTree::OP_ATAN, 1 },
+    { "sinh", ExprTree::OP_SINH, 1 }, { "cosh", ExprTree::OP_COSH, 1 }, { "tanh", ExprTree::OP_TANH, 1 },
+    { "exp", ExprTree::OP_EXP, 1 },   { "log", ExprTree::OP_LOG, 1 },   { "log10", ExprTree::OP_LOG10, 1 },
+    { "log2", ExprTree::OP_LOG2, 1 }, { "sqrt", ExprTree::OP_SQRT, 1 }, { "abs", ExprTree::OP_ABS, 1 },
+    { "sgn", ExprTree::OP_SGN, 1 },   { "floor", ExprTree::OP_FLOOR, 1 }, { "ceil", ExprTree::OP_CEIL, 1 },
+    { "pow", ExprTree::OP_POW, 2 },   { "min", ExprTree::OP_MIN, 2 },   { "max", ExprTree::OP_MAX, 2 },
+};
+
+// Recursive descent parser building nodes bottom-up
+class Parser {
+public:
+    Parser(const std::string& s, const std::vector<std::string>& vars,
+        const std::function<int(ExprTree::Node)>& add)
+        : s_(s), vars_(vars), add_(add) {}
+
+    int parseAll(std::string& error) {
+        int root = additive();
+        skip();
+        if (root >= 0 && pos_ != s_.size()) fail("unexpected '" + std::string(1, s_[pos_]) + "'");
+        error = error_;
+        return error_.empty() ? root : -1;
+    }
+
+private:
+    void skip() { while (pos_ < s_.size() && std::isspace((unsigned char)s_[pos_])) ++pos_; }
+    bool eat(char c) {
+        skip();
+        if (pos_ < s_.size() && s_[pos_] == c) { ++pos_; return true; }
+        return false;
+    }
+    void fail(const std::string& msg) { if (error_.empty()) error_ = msg; }
+
+    int binary(ExprTree::Op op, int a, int b) {
+        if (a < 0 || b < 0) return -1;
+        ExprTree::Node n; n.op = op; n.a = a; n.b = b;
+        return add_(n);
+    }
+    int unary(ExprTree::Op op, int a) {
+        if (a < 0) return -1;
+        ExprTree::Node n; n.op = op; n.a = a;
+        return add_(n);
+    }
+    int constant(double v) {
+        ExprTree::Node n; n.op = ExprTree::OP_CONST; n.value = v;
+        return add_(n);
+    }
+
+    int additive() {
+        int lhs = multiplicative();
+        for (;;) {
+            if (eat('+')) lhs = binary(ExprTree::OP_ADD, lhs, multiplicative());
+            else if (eat('-')) lhs = binary(ExprTree::OP_SUB, lhs, multiplicative());
+            else return lhs;
+        }
+    }
+
+    // true when the next token can start an operand, for implicit "2x" / "2(x+1)"
+    bool startsOperand() {
+        skip();
+        if (pos_ >= s_.size()) return false;
+        char c = s_[pos_];
+        return std::isalpha((unsigned char)c) || c == '_' || c == '(';
+    }
+
+    int multiplicative() {
+        int lhs = unaryExpr();
+        for (;;) {
+            if (eat('*')) lhs = binary(ExprTree::OP_MUL, lhs, unaryExpr());
+            else if (eat('/')) lhs = binary(ExprTree::OP_DIV, lhs, unaryExpr());
+            else if (eat('%')) lhs = binary(ExprTree::OP_MOD, lhs, unaryExpr());
+            else if (lastWasNumber_ && startsOperand()) lhs = binary(ExprTree::OP_MUL, lhs, unaryExpr());
+            else return lhs;
+        }
+    }
+
+    int unaryExpr() {
+        if (eat('-')) return unary(ExprTree::OP_NEG, unaryExpr());
+        if (eat('+')) return unaryExpr();
+        return power();
+    }
+
+    int power() {
+        int base = primary();
+        if (eat('^')) return binary(ExprTree::OP_POW, base, unaryExpr());   // right associative
+        return base;
+    }
+
+    int primary() {
+        skip();
+        lastWasNumber_ = false;
+        if (pos_ >= s_.size()) { fail("unexpected end of expression"); return -1; }
+        const char c = s_[pos_];
+
+        if (std::isdigit((unsigned char)c) || c == '.') {
+            const char* begin = s_.c_str() + pos_;
+            char* end = nullptr;
+            double v = std::strtod(begin, &end);
+            if (end == begin) { fail("bad number"); return -1; }
+            pos_ += size_t(end - begin);
+            int n = constant(v);
+            lastWasNumber_ = true;
+            return n;
+        }
+
+        if (eat('(')) {
+            int inner = additive();
+            if (!eat(')')) fail("missing ')'");
+            return inner;
+        }
+
+        if (std::isalpha((unsigned char)c) || c == '_') {
+            size_t start = pos_;
+            while (pos_ < s_.size() && (std::isalnum((unsigned char)s_[pos_]) || s_[pos_] == '_')) ++pos_;
+            std::string name = s_.substr(start, pos_ - start);
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+            for (const auto& f : kFuncs) {
+                if (name != f.name) continue;
+                if (!eat('(')) { fail("expected '(' after " + name); return -1; }
+                int a = additive();
+                int b = -1;
+                if (f.args == 2) {
+                    if (!eat(',')) { fail(name + " takes two arguments"); return -1; }
+                    b = additive();
+                }
+                if (!eat(')')) { fail("missing ')'"); return -1; }
+                return f.args == 2 ? binary(f.op, a, b) : unary(f.op, a);
+            }
+            for (size_t v = 0; v < vars_.size(); ++v) {
+                if (name != vars_[v]) continue;
+                ExprTree::Node n; n.op = ExprTree::OP_VAR; n.var = (int)v;
+                return add_(n);
+            }
+            if (name == "pi") return constant(3.14159265358979323846);
+            if (name == "epsilon") return constant(std::numeric_limits<double>::epsilon());
+            if (name == "inf") return constant(std::numeric_limits<double>::infinity());
+            fail("unsupported symbol '" + name + "'");
+            return -1;
+        }
+
+        fail("unsupported token '" + std::string(1, c) + "'");
+        return -1;
+    }
+
+    const std::string& s_;
+    const std::vector<std::string>& vars_;
+    const std::function<int(ExprTree::Node)>& add_;
+    size_t pos_ = 0;
+    bool lastWasNumber_ = false;
+    std::string error_;
+};
+
+} // namespace
+
+int ExprTree::add(Node n) {
+    uint32_t m = 0;
+    if (n.op == OP_VAR) m = n.var < 32 ? (1u << n.var) : 0u;
+    if (n.a >= 0) m |= masks_[n.a];
+    if (n.b >= 0) m |= masks_[n.b];
+    nodes_.push_back(n);
+    masks_.push_back(m);
+    return (int)nodes_.size() - 1;
+}
+
+bool ExprTree::parse(const std::string& src, const std::vector<std::string>& vars) {
+    nodes_.clear();
+    masks_.clear();
+    error_.clear();
+    std::function<int(Node)> add = [this](Node n) { return this->add(n); };
+    Parser p(src, vars, add);
+    root_ = p.parseAll(error_);
+    if (root_ < 0) { nodes_.clear(); masks_.clear(); }
+    return root_ >= 0;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+
+// Scalar helpers the tree evaluator calls unqualified, so number types such as
+// Dual2 can provide their own overloads next to their definition.
+inline double esgn(double v) { return v > 0.0 ? 1.0 : (v < 0.0 ? -1.0 : 0.0); }
+inline double emin(double a, double b) { return a < b ? a : b; }
+inline double emax(double a, double b) { return a > b ? a : b; }
+inline double epowc(double a, double c) { return std::pow(a, c); }
+
+// Expression tree for the arithmetic subset of the exprtk syntax
+// (+ - * / % ^, unary minus, implicit "2x", common functions, pi/epsilon/inf).
+// exprtk stays the authority for plain values; the tree exists so the same
+// expression can be evaluated over other number types (derivatives, bounds).
+// Anything outside the subset (loops, assignments, strings) fails to parse.
+class ExprTree {
+public:
+    enum Op : uint8_t {
+        OP_CONST, OP_VAR, OP_NEG,
+        OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_POW, OP_MOD, OP_MIN, OP_MAX,
+        OP_SIN, OP_COS, OP_TAN, OP_ASIN, OP_ACOS, OP_ATAN,
+        OP_SINH, OP_COSH, OP_TANH, OP_EXP, OP_LOG, OP_LOG10, OP_LOG2,
+        OP_SQRT, OP_ABS, OP_SGN, OP_FLOOR, OP_CEIL,
+    };
+
+    struct Node {
+        Op op = OP_CONST;
+        int a = -1, b = -1;    // child node indices (children precede parents)
+        double value = 0.0;    // OP_CONST
+        int var = 0;           // OP_VAR, index into the variable list
+    };
+
+    // Parse src with the given variable names (index = position in the list)
+    bool parse(const std::string& src, const std::vector<std::string>& vars);
+
+    bool valid() const { return root_ >= 0; }
+    const std::string& error() const { return error_; }
+    const std::vector<Node>& nodes() const { return nodes_; }
+    int root() const { return root_; }
+
+    // Bit v set when node i depends on variable v (first 32 variables)
+    uint32_t mask(int i) const { return masks_[i]; }
+
+    template <class T>
+    T eval(const T* vars) const { return evalNode<T>(root_, vars); }
+
+    template <class T>
+    T evalNode(int i, const T* vars) const;
+
+    // Result of node n given the values of its children (b unused for unary ops).
+    // OP_CONST and OP_VAR are leaves and not handled here.
+    template <class T>
+    T apply(const Node& n, const T& a, const T& b) const;
+
+private:
+    int add(Node n);
+
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> masks_;
+    int root_ = -1;
+    std::string error_;
+};
+
+template <class T>
+T ExprTree::evalNode(int i, const T* vars) const {
+    const Node& n = nodes_[i];
+    switch (n.op) {
+    case OP_CONST: return T(n.value);
+    case OP_VAR:   return vars[n.var];
+    default: break;
+    }
+    const T a = evalNode<T>(n.a, vars);
+    // constant exponents are read from the node itself, no need to evaluate them
+    if (n.b < 0 || (n.op == OP_POW && nodes_[n.b].op == OP_CONST)) return apply<T>(n, a, a);
+    return apply<T>(n, a, evalNode<T>(n.b, vars));
+}
+
+template <class T>
+T ExprTree::apply(const Node& n, const T& a, const T& b) const {
+    using std::sin; using std::cos; using std::tan; using std::asin; using std::acos;
+    using std::atan; using std::sinh; using std::cosh; using std::tanh; using std::exp;
+    using std::log; using std::log10; using std::log2; using std::sqrt; using std::fabs;
+    using std::floor; using std::ceil; using std::pow; using std::fmod;
+
+    switch (n.op) {
+    case OP_NEG:   return -a;
+    case OP_ADD:   return a + b;
+    case OP_SUB:   return a - b;
+    case OP_MUL:   return a * b;
+    case OP_DIV:   return a / b;
+    case OP_POW:
+        // constant exponents keep negative bases and integer powers exact
+        if (nodes_[n.b].op == OP_CONST) return epowc(a, nodes_[n.b].value);
+        return pow(a, b);
+    case OP_MOD:   return fmod(a, b);
+    case OP_MIN:   return emin(a, b);
+    case OP_MAX:   return emax(a, b);
+    case OP_SIN:   return sin(a);
+    case OP_COS:   return cos(a);
+    case OP_TAN:   return tan(a);
+    case OP_ASIN:  return asin(a);
+    case OP_ACOS:  return acos(a);
+    case OP_ATAN:  return atan(a);
+    case OP_SINH:  return sinh(a);
+    case OP_COSH:  return cosh(a);
+    case OP_TANH:  return tanh(a);
+    case OP_EXP:   return exp(a);
+    case OP_LOG:   return log(a);
+    case OP_LOG10: return log10(a);
+    case OP_LOG2:  return log2(a);
+    case OP_SQRT:  return sqrt(a);
+    case OP_ABS:   return fabs(a);
+    case OP_SGN:   return esgn(a);
+    case OP_FLOOR: return floor(a);
+    case OP_CEIL:  return ceil(a);
+    default: break;
+    }
+    return T(0.0);
+}
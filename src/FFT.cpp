@@ -0,0 +1,451 @@
+#include "FFT.h"
+#include "ThreadPool.h"
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <algorithm>
+
+static const int kMaxRadix = 13;             // largest prime the mixed-radix plan handles
+static const int kParallelMin = 2048;        // smaller sizes never try worker threads
+
+struct FFT::Plan {
+    int n = 0;
+    int algo = FFT_RADIX2;
+    int threads = 1;
+
+    // radix-2 tables (size n for FFT_RADIX2, size m for FFT_BLUESTEIN)
+    std::vector<int>  bitrev;
+    std::vector<cplx> twiddles;   // exp(-j*2*pi*k/len), k < len/2
+
+    // mixed radix: (radix, remaining length) per stage and the n roots exp(-j*2*pi*k/n)
+    std::vector<int>  factors;
+    std::vector<cplx> roots;
+
+    // Bluestein: chirp w[k] = exp(-j*pi*k^2/n) and FFT of its padded conjugate
+    int m = 0;
+    std::vector<cplx> chirp;
+    std::vector<cplx> chirpSpec;
+};
+
+// fn(lo, hi) over [0, count) in `threads` contiguous chunks
+template <class Fn>
+static void forChunks(int threads, int count, Fn&& fn) {
+    if (threads <= 1 || count < 2 * threads) { fn(0, count); return; }
+    ThreadPool::Shared().parallelFor(0, threads, [&](int t) {
+        fn((int)((long long)count * t / threads), (int)((long long)count * (t + 1) / threads));
+    });
+}
+
+static void buildRadix2(FFT::Plan& p, int len) {
+    p.bitrev.resize(len);
+    int bits = 0;
+    while ((1 << bits) < len) ++bits;
+    for (int i = 0; i < len; ++i) {
+        int r = 0;
+        for (int b = 0; b < bits; ++b) if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        p.bitrev[i] = r;
+    }
+    p.twiddles.resize(std::max(1, len / 2));
+    for (int k = 0; k < len / 2; ++k) {
+        double ang = -2.0 * M_PI * k / len;
+        p.twiddles[k] = { std::cos(ang), std::sin(ang) };
+    }
+}
+
+// Iterative decimation-in-time radix-2 butterfly; len must match the plan tables.
+// With threads > 1 every stage splits its len/2 independent butterflies.
+static void radix2(const FFT::Plan& p, FFT::cplx* a, int len, bool inv) {
+    const int threads = len >= kParallelMin ? p.threads : 1;
+    forChunks(threads, len, [&](int lo, int hi) {
+        for (int i = lo; i < hi; ++i)
+            if (i < p.bitrev[i]) std::swap(a[i], a[p.bitrev[i]]);
+    });
+
+    for (int half = 1; half < len; half <<= 1) {
+        const int stride = len / (2 * half);
+        forChunks(threads, len / 2, [&](int lo, int hi) {
+            for (int b = lo; b < hi; ++b) {
+                const int k = b & (half - 1);
+                const int s = (b - k) * 2;
+                FFT::cplx w = p.twiddles[k * stride];
+                if (inv) w = std::conj(w);
+                FFT::cplx u = a[s + k];
+                FFT::cplx v = a[s + k + half] * w;
+                a[s + k] = u + v;
+                a[s + k + half] = u - v;
+            }
+        });
+    }
+}
+
+// Radices 4 first (radix-4 stages for powers of two), then 2, then odd primes;
+// false when n has a prime factor above kMaxRadix
+static bool factorize(int n, std::vector<int>& factors) {
+    factors.clear();
+    int rem = n;
+    auto take = [&](int r) {
+        while (rem % r == 0) {
+            rem /= r;
+            factors.push_back(r);
+            factors.push_back(rem);
+        }
+    };
+    take(4);
+    take(2);
+    for (int r = 3; r <= kMaxRadix; r += 2) take(r);
+    return n > 1 && rem == 1;
+}
+
+// Combine r interleaved sub-transforms of length m (Fout[q*m + u]) in place
+static void mixedButterfly(const FFT::Plan& p, FFT::cplx* out, int fstride, int m, int r, bool inv, int threads) {
+    auto tw = [&](int idx) { return inv ? std::conj(p.roots[idx]) : p.roots[idx]; };
+    forChunks(m >= kParallelMin / r ? threads : 1, m, [&](int lo, int hi) {
+        if (r == 2) {
+            for (int u = lo; u < hi; ++u) {
+                const FFT::cplx t = out[u + m] * tw(u * fstride);
+                out[u + m] = out[u] - t;
+                out[u] += t;
+            }
+        }
+        else if (r == 4) {
+            for (int u = lo; u < hi; ++u) {
+                const FFT::cplx s0 = out[u + m] * tw(u * fstride);
+                const FFT::cplx s1 = out[u + 2 * m] * tw(2 * u * fstride);
+                const FFT::cplx s2 = out[u + 3 * m] * tw(3 * u * fstride);
+                const FFT::cplx s5 = out[u] - s1;
+                const FFT::cplx s3 = s0 + s2;
+                const FFT::cplx s4 = s0 - s2;
+                const FFT::cplx a = out[u] + s1;
+                out[u] = a + s3;
+                out[u + 2 * m] = a - s3;
+                // s4 rotated by -j (forward) or +j (inverse)
+                const FFT::cplx rot = inv ? FFT::cplx(-s4.imag(), s4.real()) : FFT::cplx(s4.imag(), -s4.real());
+                out[u + m] = s5 + rot;
+                out[u + 3 * m] = s5 - rot;
+            }
+        }
+        else {
+            // any small prime: direct r-point DFT with the twiddles folded in
+            FFT::cplx scratch[kMaxRadix];
+            for (int u = lo; u < hi; ++u) {
+                for (int q = 0; q < r; ++q) scratch[q] = out[u + q * m];
+                for (int q1 = 0; q1 < r; ++q1) {
+                    const int k = u + q1 * m;
+                    int idx = 0;
+                    FFT::cplx acc = scratch[0];
+                    for (int q = 1; q < r; ++q) {
+                        idx += fstride * k;
+                        if (idx >= p.n) idx -= p.n;
+                        acc += scratch[q] * tw(idx);
+                    }
+                    out[k] = acc;
+                }
+            }
+        }
+    });
+}
+
+// Recursive decimation in time: out gets the transform of in[0], in[fstride], ...
+static void mixedWork(const FFT::Plan& p, FFT::cplx* out, const FFT::cplx* in, int fstride,
+    const int* f, bool inv, int threads)
+{
+    const int r = f[0], m = f[1];
+    if (m == 1) {
+        for (int q = 0; q < r; ++q) out[q] = in[q * fstride];
+    }
+    else if (threads > 1 && m * r >= kParallelMin) {
+        // the r sub-transforms are independent
+        ThreadPool::Shared().parallelFor(0, r, [&](int q) {
+            mixedWork(p, out + q * m, in + q * fstride, fstride * r, f + 2, inv, 1);
+        });
+    }
+    else {
+        for (int q = 0; q < r; ++q)
+            mixedWork(p, out + q * m, in + q * fstride, fstride * r, f + 2, inv, 1);
+    }
+    mixedButterfly(p, out, fstride, m, r, inv, threads);
+}
+
+static void mixed(const FFT::Plan& p, std::vector<FFT::cplx>& data, bool inv) {
+    const std::vector<FFT::cplx> in(data);
+    mixedWork(p, data.data(), in.data(), 1, p.factors.data(), inv, p.threads);
+}
+
+static bool eligible(int n, int algo) {
+    const bool pow2 = (n & (n - 1)) == 0;
+    std::vector<int> factors;
+    switch (algo) {
+    case FFT_RADIX2: return pow2;
+    case FFT_MIXED: return factorize(n, factors);
+    case FFT_BLUESTEIN: return !pow2;
+    default: return false;
+    }
+}
+
+static FFT::Choice defaultChoice(int n) {
+    FFT::Choice c;
+    c.algo = (n & (n - 1)) == 0 ? FFT_RADIX2 : FFT_BLUESTEIN;
+    return c;
+}
+
+static std::shared_ptr<const FFT::Plan> makePlan(int n, const FFT::Choice& c) {
+    auto p = std::make_shared<FFT::Plan>();
+    p->n = n;
+    p->algo = c.algo;
+    p->threads = std::max(1, c.threads);
+    if (p->algo == FFT_RADIX2) {
+        buildRadix2(*p, n);
+        return p;
+    }
+    if (p->algo == FFT_MIXED) {
+        factorize(n, p->factors);
+        p->roots.resize(n);
+        for (int k = 0; k < n; ++k) {
+            double ang = -2.0 * M_PI * k / n;
+            p->roots[k] = { std::cos(ang), std::sin(ang) };
+        }
+        return p;
+    }
+
+    p->m = FFT::nextPow2(2 * n - 1);
+    buildRadix2(*p, p->m);
+    p->chirp.resize(n);
+    for (int k = 0; k < n; ++k) {
+        // k^2 mod 2n keeps the angle small for large n
+        long long kk = (long long)k * k % (2LL * n);
+        double ang = -M_PI * (double)kk / n;
+        p->chirp[k] = { std::cos(ang), std::sin(ang) };
+    }
+    p->chirpSpec.assign(p->m, FFT::cplx(0.0, 0.0));
+    p->chirpSpec[0] = std::conj(p->chirp[0]);
+    for (int k = 1; k < n; ++k)
+        p->chirpSpec[k] = p->chirpSpec[p->m - k] = std::conj(p->chirp[k]);
+    radix2(*p, p->chirpSpec.data(), p->m, false);
+    return p;
+}
+
+// ---------- plan cache and wisdom ----------
+static std::mutex g_planMutex;
+static std::map<int, std::shared_ptr<const FFT::Plan>> g_plans;
+static std::map<int, FFT::Choice> g_wisdom;
+static bool g_autotune = false;
+static bool g_wisdomDirty = false;
+
+static std::shared_ptr<const FFT::Plan> cachedPlan(int n) {
+    {
+        std::lock_guard<std::mutex> lock(g_planMutex);
+        auto& slot = g_plans[n];
+        if (slot) return slot;
+        auto w = g_wisdom.find(n);
+        if (w != g_wisdom.end() || !g_autotune || n < 2) {
+            slot = makePlan(n, w != g_wisdom.end() ? w->second : defaultChoice(n));
+            return slot;
+        }
+    }
+    // first use without wisdom: measure (outside the lock), tune() installs the winner
+    FFT::tune(n);
+    std::lock_guard<std::mutex> lock(g_planMutex);
+    return g_plans[n];
+}
+
+FFT::FFT(int n) : plan_(cachedPlan(std::max(1, n))) {}
+int FFT::size() const { return plan_->n; }
+
+int FFT::nextPow2(int n) {
+    int p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+// Bluestein: X[k] = w[k] * sum_n (x[n] w[n]) conj(w[k-n]), done as a padded circular convolution
+static void bluestein(const FFT::Plan& p, std::vector<FFT::cplx>& data, bool inv) {
+    const int n = p.n;
+    std::vector<FFT::cplx> a(p.m, FFT::cplx(0.0, 0.0));
+    for (int k = 0; k < n; ++k) {
+        FFT::cplx x = inv ? std::conj(data[k]) : data[k];
+        a[k] = x * p.chirp[k];
+    }
+    radix2(p, a.data(), p.m, false);
+    for (int k = 0; k < p.m; ++k) a[k] *= p.chirpSpec[k];
+    radix2(p, a.data(), p.m, true);
+    const double scale = 1.0 / p.m;
+    for (int k = 0; k < n; ++k) {
+        FFT::cplx y = a[k] * scale * p.chirp[k];
+        data[k] = inv ? std::conj(y) : y;
+    }
+}
+
+static void transform(const FFT::Plan& p, std::vector<FFT::cplx>& data, bool inv) {
+    data.resize(p.n);
+    if (p.algo == FFT_RADIX2) radix2(p, data.data(), p.n, inv);
+    else if (p.algo == FFT_MIXED) mixed(p, data, inv);
+    else bluestein(p, data, inv);
+}
+
+void FFT::forward(std::vector<cplx>& data) const {
+    transform(*plan_, data, false);
+}
+
+void FFT::inverse(std::vector<cplx>& data) const {
+    transform(*plan_, data, true);
+    const double scale = 1.0 / plan_->n;
+    for (auto& v : data) v *= scale;
+}
+
+FFT::Choice FFT::tune(int n) {
+    using Clock = std::chrono::steady_clock;
+    n = std::max(1, n);
+    const int cores = (int)ThreadPool::Shared().concurrency();
+
+    // deterministic input, refreshed before every run so each one sees the same data
+    std::vector<cplx> input(n), data;
+    unsigned seed = 12345u;
+    for (auto& v : input) {
+        seed = seed * 1664525u + 1013904223u;
+        const double re = (seed >> 8) * (1.0 / 16777216.0) - 0.5;
+        seed = seed * 1664525u + 1013904223u;
+        v = { re, (seed >> 8) * (1.0 / 16777216.0) - 0.5 };
+    }
+
+    Choice best = defaultChoice(n);
+    std::shared_ptr<const Plan> bestPlan;
+    for (int algo = FFT_RADIX2; algo <= FFT_BLUESTEIN; ++algo) {
+        if (!eligible(n, algo)) continue;
+        for (int threads : { 1, cores }) {
+            if (threads > 1 && n < kParallelMin) continue;
+            Choice c;
+            c.algo = algo;
+            c.threads = threads;
+            auto plan = makePlan(n, c);
+            // best of at least 3 runs, up to ~2 ms per candidate
+            double bestNs = 1e300, spent = 0.0;
+            for (int run = 0; run < 50 && (run < 4 || spent < 2e6); ++run) {
+                data = input;
+                const auto t0 = Clock::now();
+                transform(*plan, data, false);
+                const double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+                if (run > 0) bestNs = std::min(bestNs, ns);   // run 0 warms caches
+                spent += ns;
+            }
+            c.ns = bestNs;
+            if (!bestPlan || c.ns < best.ns) {
+                best = c;
+                bestPlan = plan;
+            }
+            if (threads == cores) break;
+        }
+    }
+    if (!bestPlan) bestPlan = makePlan(n, best);
+
+    std::lock_guard<std::mutex> lock(g_planMutex);
+    g_wisdom[n] = best;
+    g_plans[n] = bestPlan;
+    g_wisdomDirty = true;
+    return best;
+}
+
+FFT::Choice FFT::choice(int n) {
+    std::lock_guard<std::mutex> lock(g_planMutex);
+    auto w = g_wisdom.find(n);
+    return w != g_wisdom.end() ? w->second : defaultChoice(n);
+}
+
+std::string FFT::describe(int n) {
+    const Choice c = choice(n);
+    std::ostringstream os;
+    if (c.algo == FFT_RADIX2) os << "radix-2";
+    else if (c.algo == FFT_BLUESTEIN) os << "Bluestein (" << nextPow2(2 * n - 1) << ")";
+    else {
+        std::vector<int> factors;
+        factorize(n, factors);
+        os << "mixed radix ";
+        for (size_t i = 0; i < factors.size(); i += 2) os << (i ? "x" : "") << factors[i];
+    }
+    os << ", " << c.threads << (c.threads == 1 ? " thread" : " threads");
+    return os.str();
+}
+
+void FFT::setAutotune(bool on) {
+    std::lock_guard<std::mutex> lock(g_planMutex);
+    g_autotune = on;
+}
+
+static const char* const kAlgoNames[] = { "radix2", "mixed", "bluestein" };
+
+bool FFT::loadWisdom(const std::string& path) {
+    std::ifstream f(path);
+    if (!f.is_open()) return false;
+    std::string line;
+    if (!std::getline(f, line) || line.rfind("FFTWisdom", 0) != 0) return false;
+
+    const int cores = (int)ThreadPool::Shared().concurrency();
+    std::map<int, Choice> loaded;
+    while (std::getline(f, line)) {
+        std::istringstream iss(line);
+        std::string key;
+        if (!(iss >> key) || key[0] == '#') continue;
+        if (key == "cores") {
+            int c = 0;
+            // timings from another machine say nothing about this one
+            if (!(iss >> c) || c != cores) return false;
+            continue;
+        }
+        Choice c;
+        std::string algo;
+        const int n = std::atoi(key.c_str());
+        if (n < 1 || !(iss >> algo >> c.threads >> c.ns)) continue;
+        c.algo = -1;
+        for (int a = 0; a < 3; ++a) if (algo == kAlgoNames[a]) c.algo = a;
+        if (c.algo < 0 || !eligible(n, c.algo) || c.threads < 1 || c.threads > cores) continue;
+        loaded[n] = c;
+    }
+
+    std::lock_guard<std::mutex> lock(g_planMutex);
+    for (const auto& [n, c] : loaded) {
+        g_wisdom[n] = c;
+        g_plans.erase(n);   // replanned on next use
+    }
+    g_wisdomDirty = false;
+    return true;
+}
+
+bool FFT::saveWisdom(const std::string& path) {
+    std::lock_guard<std::mutex> lock(g_planMutex);
+    std::ofstream f(path);
+    if (!f.is_open()) return false;
+    f << "FFTWisdom v1\n";
+    f << "cores " << ThreadPool::Shared().concurrency() << "\n";
+    f << "# n algorithm threads ns-per-forward\n";
+    for (const auto& [n, c] : g_wisdom)
+        f << n << " " << kAlgoNames[c.algo] << " " << c.threads << " " << (long long)std::llround(c.ns) << "\n";
+    g_wisdomDirty = !f;
+    return (bool)f;
+}
+
+bool FFT::wisdomDirty() {
+    std::lock_guard<std::mutex> lock(g_planMutex);
+    return g_wisdomDirty;
+}
+
+FourierSpectrum spectrumOf(const std::vector<double>& signal, double dt) {
+    const int N = (int)signal.size();
+    FourierSpectrum out;
+    if (N < 2 || dt <= 0.0) return out;
+    out.wMax = M_PI / dt;
+
+    std::vector<FFT::cplx> X(signal.begin(), signal.end());
+    FFT(N).forward(X);
+
+    out.freqs.resize(N);
+    out.magn.resize(N);
+    for (int k = 0; k < N; ++k) {
+        out.freqs[k] = -out.wMax + 2.0 * out.wMax * (double)k / N;
+        out.magn[k] = std::abs(X[(k + N / 2) % N]) / N;
+    }
+    out.maxAmp = *std::max_element(out.magn.begin(), out.magn.end());
+    return out;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <vector>
+#include <complex>
+#include <memory>
+#include <string>
+#include "Fourier.h"
+
+// Decompositions a plan can use
+enum FFTAlgorithm {
+    FFT_RADIX2 = 0,     // iterative radix-2, powers of two only
+    FFT_MIXED,          // recursive mixed radix (4, 2, 3, 5, ... 13); radix-4 for powers of two
+    FFT_BLUESTEIN,      // chirp-z on a padded power of two, any size
+};
+
+// Complex FFT of arbitrary length with cached plans.
+// By default powers of two run an iterative radix-2 kernel and any other size
+// goes through Bluestein's chirp-z. With wisdom (measured or loaded) a size
+// uses whichever algorithm and thread count was fastest for it on this machine.
+// Plans are shared between all FFT objects of the same size, so constructing
+// one per call is cheap.
+class FFT {
+public:
+    using cplx = std::complex<double>;
+
+    explicit FFT(int n);
+    int size() const;
+
+    // In-place transforms. forward() is unnormalized, inverse() scales by 1/N.
+    void forward(std::vector<cplx>& data) const;
+    void inverse(std::vector<cplx>& data) const;
+
+    static int nextPow2(int n);
+
+    // Plan wisdom: the measured-best algorithm and thread count per size
+    struct Choice {
+        int algo = FFT_RADIX2;
+        int threads = 1;
+        double ns = 0.0;        // one forward transform; 0 = not measured
+    };
+    // benchmark every candidate plan for n (a few ms), keep and use the winner
+    static Choice tune(int n);
+    // what size n runs with (wisdom, or the default when untuned)
+    static Choice choice(int n);
+    // "mixed radix 4x5x5x5" and the like
+    static std::string describe(int n);
+    // tune sizes that have no wisdom the first time they are planned
+    static void setAutotune(bool on);
+    // text file, one "n algo threads ns" line per size; entries are ignored
+    // when the file was written on a machine with a different core count
+    static bool loadWisdom(const std::string& path);
+    static bool saveWisdom(const std::string& path);
+    // wisdom measured since the last load or save
+    static bool wisdomDirty();
+
+    struct Plan;
+
+private:
+    std::shared_ptr<const Plan> plan_;
+};
+
+// Centered magnitude spectrum of uniformly spaced samples, laid out exactly
+// like Fourier::computeTransform (rad/s axis, |X| / N, zero frequency in the middle)
+FourierSpectrum spectrumOf(const std::vector<double>& signal, double dt);
@@ -0,0 +1,107 @@
+#include "Filter.h"
+#include "FFT.h"
+#include <cmath>
+#include <algorithm>
+
+// Ideal low-pass impulse response sin(wc*t)/(pi*t), sampled at t
+static double sincLowpass(double wc, double t) {
+    if (std::fabs(t) < 1e-12) return wc / M_PI;
+    return std::sin(wc * t) / (M_PI * t);
+}
+
+// Build the kernel taps for the current spec and cache the spectrum of one block
+void SignalFilter::rebuild(double dx, int maxTaps, const FilterSpec& spec,
+    const std::function<double(double)>& kernel)
+{
+    int half = (int)std::lround(0.5 * spec.width / dx);
+    half = std::clamp(half, 1, std::max(1, (maxTaps - 1) / 2));
+    const int L = 2 * half + 1;
+
+    auto w = Fourier::hann(L + 2);   // drop the zero end points of the window
+    taps_.assign(L, 0.0);
+    double sum = 0.0;
+    for (int i = 0; i < L; ++i) {
+        const double t = (i - half) * dx;
+        double h = 0.0;
+        switch (spec.type) {
+        case FILTER_LOWPASS:
+            h = sincLowpass(spec.high, t) * dx * w[i + 1];
+            break;
+        case FILTER_BANDPASS:
+            h = (sincLowpass(spec.high, t) - sincLowpass(spec.low, t)) * dx * w[i + 1];
+            break;
+        case FILTER_SMOOTH: {
+            const double sigma = spec.width / 6.0;
+            h = std::exp(-0.5 * t * t / (sigma * sigma));
+            break;
+        }
+        case FILTER_KERNEL:
+            h = kernel ? kernel(t) * dx : 0.0;
+            if (!std::isfinite(h)) h = 0.0;
+            break;
+        }
+        taps_[i] = h;
+        sum += h;
+    }
+    // unity DC gain for the smoothing kernel, user kernels keep their own scale
+    if (spec.type == FILTER_SMOOTH && sum != 0.0)
+        for (double& h : taps_) h /= sum;
+
+    block_ = FFT::nextPow2(std::max(4 * L, 1024));
+    kernelSpec_.assign(block_, { 0.0, 0.0 });
+    for (int i = 0; i < L; ++i) kernelSpec_[i] = taps_[i];
+    FFT(block_).forward(kernelSpec_);
+
+    spec_ = spec;
+    dx_ = dx;
+    maxTaps_ = maxTaps;
+    ready_ = true;
+}
+
+// Overlap-save: each block of M padded samples is transformed, multiplied by the
+// kernel spectrum and transformed back; the first L-1 outputs are wrapped-around
+// garbage and the remaining M-L+1 are valid linear convolution samples.
+// Two real blocks share one complex FFT (real and imaginary lanes) because the
+// kernel is real.
+void SignalFilter::apply(const std::vector<double>& x, double dx, const FilterSpec& spec,
+    const std::function<double(double)>& kernel, std::vector<double>& y)
+{
+    const int N = (int)x.size();
+    y.assign(N, 0.0);
+    if (N == 0 || dx <= 0.0) return;
+
+    if (!ready_ || !(spec == spec_) || dx != dx_ || N != maxTaps_)
+        rebuild(dx, N, spec, kernel);
+
+    const int L = (int)taps_.size();
+    const int half = L / 2;
+    const int M = block_;
+    const int step = M - L + 1;
+
+    // edge-extended input: x[n] sits at padded_[n + half], so output n of the
+    // centred convolution is the linear convolution sample at padded index n + L - 1
+    const int total = N + L - 1;
+    padded_.resize(total);
+    for (int i = 0; i < total; ++i)
+        padded_[i] = x[std::clamp(i - half, 0, N - 1)];
+    auto sampleAt = [&](int i) { return i < total ? padded_[i] : 0.0; };
+
+    const FFT fft(M);
+    for (int s = 0; s < N; s += 2 * step) {
+        const int s2 = s + step;
+        work_.resize(M);
+        for (int i = 0; i < M; ++i) {
+            double a = sampleAt(s + i);
+            double b = (s2 < N) ? sampleAt(s2 + i) : 0.0;
+            work_[i] = { a, b };
+        }
+        fft.forward(work_);
+        for (int i = 0; i < M; ++i) work_[i] *= kernelSpec_[i];
+        fft.inverse(work_);
+
+        for (int j = 0; j < step && s + j < N; ++j)
+            y[s + j] = work_[L - 1 + j].real();
+        for (int j = 0; j < step && s2 + j < N; ++j)
+            y[s2 + j] = work_[L - 1 + j].imag();
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <complex>
+#include <functional>
+
+enum FilterType {
+    FILTER_LOWPASS = 0,
+    FILTER_BANDPASS,
+    FILTER_SMOOTH,
+    FILTER_KERNEL,
+};
+
+// Filter definition in world units. Cutoffs are angular frequencies (rad/s,
+// same axis as the spectrum window), width is the kernel support along x.
+struct FilterSpec {
+    int    type = FILTER_LOWPASS;
+    double low = 0.0;
+    double high = 10.0;
+    double width = 2.0;
+    std::string kernelExpr;   // only used as cache key for FILTER_KERNEL
+
+    bool operator==(const FilterSpec& o) const {
+        return type == o.type && low == o.low && high == o.high &&
+            width == o.width && kernelExpr == o.kernelExpr;
+    }
+};
+
+// FFT overlap-save convolution of uniformly sampled signals.
+// The kernel taps and their block spectrum are cached until the spec, the
+// sample spacing or the kernel length change, so steady-state frames only pay
+// for the block transforms of the signal itself.
+class SignalFilter {
+public:
+    // y = (x * h) centred on the kernel, same length as x. Edges are extended
+    // by repeating the boundary samples. kernel(t) is used for FILTER_KERNEL.
+    void apply(const std::vector<double>& x, double dx, const FilterSpec& spec,
+        const std::function<double(double)>& kernel, std::vector<double>& y);
+
+    const std::vector<double>& taps() const { return taps_; }
+
+private:
+    void rebuild(double dx, int maxTaps, const FilterSpec& spec,
+        const std::function<double(double)>& kernel);
+
+    FilterSpec spec_;
+    double dx_ = 0.0;
+    int maxTaps_ = 0;
+    bool ready_ = false;
+
+    std::vector<double> taps_;
+    int block_ = 0;                                  // FFT block length M
+    std::vector<std::complex<double>> kernelSpec_;   // FFT of taps padded to M
+
+    // scratch reused between calls
+    std::vector<double> padded_;
+    std::vector<std::complex<double>> work_;
+};
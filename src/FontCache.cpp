@@ -0,0 +1,155 @@
+#include "FontCache.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <iterator>
+#include <vector>
+
+static const uint32_t kAtlasVersion = 1;
+
+struct AtlasHeader {
+    char     magic[4];            // "FVFA"
+    uint32_t version;
+    uint64_t key;
+    int32_t  texWidth, texHeight;
+    uint32_t glyphs;
+    uint32_t lines;               // TexUvLines entries
+    float    fontSize, ascent, descent;
+    uint32_t fallbackChar, ellipsisChar;
+    float    uvScale[2], uvWhite[2];
+};
+
+static uint64_t Fnv1a(const char* p, size_t n) {
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= (unsigned char)p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+static uint64_t CacheKey(const std::string& ttf, float size, const ImWchar* ranges) {
+    std::error_code ec;
+    const auto bytes = std::filesystem::file_size(ttf, ec);
+    const auto mtime = std::filesystem::last_write_time(ttf, ec).time_since_epoch().count();
+    std::string key = ttf + "|" + std::to_string(bytes) + "|" + std::to_string(mtime) + "|" +
+        std::to_string(size) + "|" + std::to_string(IMGUI_VERSION_NUM) + "|" + std::to_string(sizeof(ImFontGlyph)) + "|";
+    for (const ImWchar* r = ranges; r && r[0]; r += 2)
+        key += std::to_string(r[0]) + "-" + std::to_string(r[1]) + ",";
+    return Fnv1a(key.data(), key.size());
+}
+
+// Restoring a baked atlas has no public API in this ImGui generation, so the
+// two functions below fill in ImFont and ImFontAtlas fields directly (glyph
+// table, metrics, texture, TexUvLines, TexReady). They are the only code that
+// touches those internals. An ImGui outside the versions they were checked
+// against stops the build here instead of misreading the fields.
+static_assert(IMGUI_VERSION_NUM >= 18700 && IMGUI_VERSION_NUM < 19200,
+    "FontCache reads and writes ImFont / ImFontAtlas internals; recheck RestoreFont and SnapshotFont");
+
+static void SnapshotFont(const ImFontAtlas& atlas, const ImFont& font, AtlasHeader& h) {
+    h.texWidth = atlas.TexWidth;
+    h.texHeight = atlas.TexHeight;
+    h.glyphs = (uint32_t)font.Glyphs.Size;
+    h.lines = (uint32_t)IM_ARRAYSIZE(atlas.TexUvLines);
+    h.fontSize = font.FontSize;
+    h.ascent = font.Ascent;
+    h.descent = font.Descent;
+    h.fallbackChar = font.FallbackChar;
+    h.ellipsisChar = font.EllipsisChar;
+    h.uvScale[0] = atlas.TexUvScale.x;
+    h.uvScale[1] = atlas.TexUvScale.y;
+    h.uvWhite[0] = atlas.TexUvWhitePixel.x;
+    h.uvWhite[1] = atlas.TexUvWhitePixel.y;
+}
+
+// lines, glyphs and pixels as laid out after the header
+static void RestoreFont(ImFontAtlas& atlas, const AtlasHeader& h, const char* lines,
+    const char* glyphs, const char* pixels)
+{
+    ImFont* font = IM_NEW(ImFont);
+    font->FontSize = h.fontSize;
+    font->Ascent = h.ascent;
+    font->Descent = h.descent;
+    font->FallbackChar = (ImWchar)h.fallbackChar;
+    font->EllipsisChar = (ImWchar)h.ellipsisChar;
+    font->ContainerAtlas = &atlas;
+    font->Glyphs.resize((int)h.glyphs);
+    std::memcpy(font->Glyphs.Data, glyphs, (size_t)h.glyphs * sizeof(ImFontGlyph));
+    font->BuildLookupTable();
+    atlas.Fonts.push_back(font);
+
+    const size_t pixelBytes = (size_t)h.texWidth * h.texHeight;
+    std::memcpy(atlas.TexUvLines, lines, (size_t)h.lines * sizeof(ImVec4));
+    atlas.TexPixelsAlpha8 = (unsigned char*)IM_ALLOC(pixelBytes);
+    std::memcpy(atlas.TexPixelsAlpha8, pixels, pixelBytes);
+    atlas.TexWidth = h.texWidth;
+    atlas.TexHeight = h.texHeight;
+    atlas.TexUvScale = ImVec2(h.uvScale[0], h.uvScale[1]);
+    atlas.TexUvWhitePixel = ImVec2(h.uvWhite[0], h.uvWhite[1]);
+    atlas.TexReady = true;
+}
+
+static bool LoadAtlas(ImFontAtlas& atlas, const std::string& path, uint64_t key) {
+    std::ifstream f(path, std::ios::in | std::ios::binary);
+    if (!f.is_open()) return false;
+    const std::vector<char> bytes((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+
+    AtlasHeader h;
+    if (bytes.size() < sizeof(h)) return false;
+    std::memcpy(&h, bytes.data(), sizeof(h));
+    const size_t lineBytes = (size_t)h.lines * sizeof(ImVec4);
+    const size_t glyphBytes = (size_t)h.glyphs * sizeof(ImFontGlyph);
+    const size_t pixelBytes = (size_t)h.texWidth * h.texHeight;
+    if (std::memcmp(h.magic, "FVFA", 4) != 0 || h.version != kAtlasVersion || h.key != key ||
+        h.lines != (uint32_t)IM_ARRAYSIZE(atlas.TexUvLines) || h.texWidth <= 0 || h.texHeight <= 0 ||
+        bytes.size() != sizeof(h) + lineBytes + glyphBytes + pixelBytes)
+        return false;
+    const char* p = bytes.data() + sizeof(h);
+    RestoreFont(atlas, h, p, p + lineBytes, p + lineBytes + glyphBytes);
+    return true;
+}
+
+static void SaveAtlas(const ImFontAtlas& atlas, const ImFont& font, const unsigned char* pixels,
+    const std::string& path, uint64_t key)
+{
+    AtlasHeader h;
+    std::memcpy(h.magic, "FVFA", 4);
+    h.version = kAtlasVersion;
+    h.key = key;
+    SnapshotFont(atlas, font, h);
+
+    // a write cut short fails the size check on the next load
+    std::ofstream f(path, std::ios::out | std::ios::binary);
+    f.write((const char*)&h, sizeof(h));
+    f.write((const char*)atlas.TexUvLines, sizeof(atlas.TexUvLines));
+    f.write((const char*)font.Glyphs.Data, (size_t)font.Glyphs.Size * sizeof(ImFontGlyph));
+    f.write((const char*)pixels, (size_t)atlas.TexWidth * atlas.TexHeight);
+}
+
+FontLoad LoadFontCached(ImFontAtlas& atlas, const std::string& ttfPath, float sizePixels,
+    const ImWchar* ranges, const std::string& cachePath)
+{
+    FontLoad r;
+    std::error_code ec;
+    if (!std::filesystem::exists(ttfPath, ec)) {
+        r.fontFound = false;
+        atlas.AddFontDefault();
+        atlas.Build();
+        return r;
+    }
+
+    const uint64_t key = CacheKey(ttfPath, sizePixels, ranges);
+    if (LoadAtlas(atlas, cachePath, key)) {
+        r.fromCache = true;
+        return r;
+    }
+
+    ImFont* font = atlas.AddFontFromFileTTF(ttfPath.c_str(), sizePixels, nullptr, ranges);
+    unsigned char* pixels = nullptr;
+    int w = 0, h = 0;
+    atlas.GetTexDataAsAlpha8(&pixels, &w, &h);
+    if (font && pixels) SaveAtlas(atlas, *font, pixels, cachePath, key);
+    return r;
+}
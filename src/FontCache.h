@@ -0,0 +1,16 @@
+#pragma once
+#include <string>
+#include <imgui/imgui.h>
+
+// Baked font atlas kept on disk between launches. The cache key covers the
+// font file (path, size, modification time), the pixel size, the glyph
+// ranges and the ImGui version; on any mismatch the font is rasterized
+// again and the cache rewritten. The atlas is built on return, so this can
+// run on a worker before the ImGui context that will use the atlas exists.
+struct FontLoad {
+    bool fromCache = false;
+    bool fontFound = true;    // false: the file is missing, ImGui's default font is used
+};
+
+FontLoad LoadFontCached(ImFontAtlas& atlas, const std::string& ttfPath, float sizePixels,
+    const ImWchar* ranges, const std::string& cachePath);
@@ -3,6 +3,7 @@
 #include <cstdio>
 #include <algorithm>
 #include "Config.h"
+#include "FFT.h"
 
 Fourier::Fourier(int fs) : Fs_(fs) {}
 int Fourier::Fs() const { return Fs_; }
@@ -38,10 +39,10 @@ void Fourier::applyWindow(std::vector<double>& frame, const std::vector<double>&
 }
 
 // Discrete Fourier Transform: converts signal from time to frequency domain
+// Evaluated with the cached FFT plans, O(N log N) for any N
 std::vector<std::complex<double>> Fourier::dft(const std::vector<double>& x) const {
-    const int N = (int)x.size();
-    std::vector<std::complex<double>> X(N);
-    for (int k = 0; k < N; ++k) X[k] = dftAt(x, k);
+    std::vector<std::complex<double>> X(x.begin(), x.end());
+    FFT((int)x.size()).forward(X);
     return X;
 }
 
@@ -85,14 +86,7 @@ std::vector<std::vector<double>> Fourier::stftMagnitude(const std::vector<double
 
 // Compute DFT for real-valued frame
 std::vector<std::complex<double>> Fourier::dftReal(const std::vector<double>& frame) const {
-    const int M = (int)frame.size();
-    std::vector<std::complex<double>> Y(M);
-    for (int k = 0; k < M; ++k) {
-        std::complex<double> s(0.0, 0.0);
-        for (int n = 0; n < M; ++n) s += frame[n] * twiddle(k, n, M);
-        Y[k] = s;
-    }
-    return Y;
+    return dft(frame);
 }
 
 // Modulate a signal using exp(-j*pi*n) pattern. Used for visualization of Fourier modulation modes
@@ -2,10 +2,13 @@
 
 #include <imgui/imgui_impl_dx9.h>
 #include <imgui/imgui_impl_win32.h>
+#include "FFT.h"
+#include <algorithm>
+#include <cmath>
 
-void GuiManager::Init(HWND hwnd, RendererDX9& renderer) {
+void GuiManager::Init(HWND hwnd, RendererDX9& renderer, ImFontAtlas* fonts) {
     IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
+    ImGui::CreateContext(fonts);
     ImGui::StyleColorsLight();
     ImGui_ImplWin32_Init(hwnd);
     ImGui_ImplDX9_Init(renderer.GetDevice());
@@ -28,6 +31,21 @@ void GuiManager::EndFrame(RendererDX9& renderer) {
     ImGui_ImplDX9_RenderDrawData(ImGui::GetDrawData());
 }
 
+bool GuiManager::TakeExportRequest(int& width, std::string& path) {
+    if (!m_exportRequested) return false;
+    m_exportRequested = false;
+    width = m_exportWidth;
+    path = m_exportPath;
+    return true;
+}
+
+bool GuiManager::TakeRecordToggle(std::string& path) {
+    if (!m_recordToggled) return false;
+    m_recordToggled = false;
+    path = m_recordPath;
+    return true;
+}
+
 static void HelpMarker(const char* d) { ImGui::SameLine(); ImGui::TextDisabled("(?)"); if (ImGui::IsItemHovered()) ImGui::SetTooltip("%s", d); }
 
 void GuiManager::ShowMainMenu(AppConfig& cfg, Scene& scene) {
@@ -40,13 +58,231 @@ void GuiManager::ShowMainMenu(AppConfig& cfg, Scene& scene) {
             scene.SetExpression(cfg.funcExprBuf());
         }
         if (scene.HasError()) ImGui::TextColored({ 1,0,0,1 }, "%s", scene.GetLastError().c_str());
+        if (scene.IsCompiling()) ImGui::TextDisabled("Compiling... (previous expression shown)");
+        const ExprCache& cache = scene.GetCache();
+        ImGui::TextDisabled("Cache: %d programs, %ld hits, %ld misses", (int)cache.size(), cache.hits(), cache.misses());
+        const ExprProfile& prof = scene.GetProfile();
+        ImGui::TextDisabled("Cost: %.2f us/eval, %d tokens%s", prof.evalUs, prof.tokens,
+            prof.loops ? ", loops (guarded)" : "");
+        ImGui::DragFloat("Eval budget (ms)", &cfg.evalBudgetMs, 0.5f, 2.0f, 500.0f);
+        HelpMarker("Sampling passes over budget are cut short and N is reduced until a frame fits.");
+        const AutoSamples& autoN = scene.GetAutoSamples();
+        const bool autoActive = cfg.autoSamples && autoN.active;
+        const int wanted = autoActive ? std::max(autoN.curveN, autoN.spectrumN) : cfg.samples;
+        if (scene.GetSampleLimit() < wanted)
+            ImGui::TextColored({ 0.8f,0.4f,0,1 }, "Slow expression: sampling with N = %d", scene.GetSampleLimit());
+        if (scene.WasAborted())
+            ImGui::TextColored({ 1,0,0,1 }, "Last pass exceeded the evaluation budget");
         ImGui::ColorEdit4("Color", (float*)&cfg.funcColor);
+        ImGui::Checkbox("Auto N", &cfg.autoSamples);
+        HelpMarker("Estimates the bandwidth of f from a coarse spectrum of the plotted range and of the\n"
+            "transform window. The curve gets enough samples for that bandwidth, at most one per pixel;\n"
+            "the transform gets the smallest FFT-friendly N (2^i 3^j 5^k) that keeps aliasing under the tolerance.");
+        if (cfg.autoSamples) {
+            ImGui::DragFloat("Alias tolerance", &cfg.aliasTolerance, 0.0001f, 1e-6f, 0.1f, "%.1e", ImGuiSliderFlags_Logarithmic);
+            if (autoActive) {
+                ImGui::TextDisabled("Curve: N = %d, bandwidth %.3g rad/unit, alias error %.1e",
+                    autoN.curveN, autoN.curveBandwidth, autoN.curveAlias);
+                ImGui::TextDisabled("Spectrum: N = %d, bandwidth %.3g rad/unit, alias error %.1e",
+                    autoN.spectrumN, autoN.spectrumBandwidth, autoN.spectrumAlias);
+                if (!autoN.resolved)
+                    ImGui::TextColored({ 0.8f,0.4f,0,1 }, "Spectrum still rising at the probe limit, errors are lower bounds");
+            }
+            else ImGui::TextDisabled("No estimate (non-finite values or empty window), using N below");
+        }
+        ImGui::BeginDisabled(autoActive);
         ImGui::DragInt("Samples (N)", &cfg.samples, 1, 64, 16384);
         HelpMarker("Higher N = finer spectrum. Use power of two for FFT.");
         if (ImGui::Button("Snap N to 2^k")) {
             int n = cfg.samples; int p = 1; while (p < n) p <<= 1; int lo = p >> 1, hi = p;
             cfg.samples = (n - lo < hi - n) ? lo : hi; if (cfg.samples < 64) cfg.samples = 64;
         }
+        ImGui::EndDisabled();
+        const int fftN = autoActive ? autoN.spectrumN : cfg.samples;
+        const FFT::Choice plan = FFT::choice(fftN);
+        ImGui::TextDisabled("FFT: %s%s", FFT::describe(fftN).c_str(),
+            plan.ns > 0.0 ? "" : " (untuned)");
+        if (plan.ns > 0.0) { ImGui::SameLine(); ImGui::TextDisabled("%.1f us", plan.ns / 1000.0); }
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Retune")) FFT::tune(fftN);
+        HelpMarker("Each transform size is benchmarked once (radix-2, mixed radix, Bluestein, 1 or all threads)\n"
+            "and the fastest plan is kept in fft_wisdom.txt next to config.ini.");
+        ImGui::Checkbox("Interval plotting", &cfg.intervalPlot);
+        HelpMarker("Bounds f over whole x-ranges: skips off-screen and flat parts, splits around poles and spikes.");
+        if (cfg.intervalPlot) {
+            if (scene.HasExprTree()) {
+                const TraceStats& ts = scene.GetTraceStats();
+                ImGui::TextDisabled("cells %d (culled %d, flat %d), points %d, breaks %d",
+                    ts.cells, ts.culled, ts.flat, ts.points, ts.breaks);
+            }
+            else ImGui::TextDisabled("Expression outside the interval subset, using samples");
+        }
+        ImGui::Checkbox("Chebyshev proxy", &cfg.chebProxy);
+        HelpMarker("Fits f once per view with piecewise Chebyshev series and samples the fit instead of the expression. Pays off for costly expressions.");
+        const ChebProxy& proxy = scene.GetProxy();
+        if (cfg.chebProxy && proxy.valid()) {
+            if (proxy.converged())
+                ImGui::TextDisabled("Converged: %d pieces, degree <= %d, %ld evaluations",
+                    (int)proxy.pieces().size(), proxy.maxDegree(), proxy.evals());
+            else
+                ImGui::TextColored({ 0.8f,0.4f,0,1 }, "Not converged (discontinuity?), unresolved pieces use the expression");
+
+            // log10 |c_k|: straight decay = smooth, plateau = noise floor or kinks
+            static std::vector<float> logc;
+            const auto& spec = proxy.spectrum();
+            logc.resize(spec.size());
+            for (size_t k = 0; k < spec.size(); ++k)
+                logc[k] = (float)std::log10(std::max(spec[k], 1e-18));
+            ImGui::PlotLines("##chebspec", logc.data(), (int)logc.size(), 0,
+                "log10 |c_k|", -18.0f, 2.0f, ImVec2(0, 60));
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Variables")) {
+        ImGui::Checkbox("Animate t", &cfg.animate);
+        ImGui::SameLine();
+        if (ImGui::Button("Reset t")) cfg.time = 0.0f;
+        ImGui::DragFloat("t", &cfg.time, 0.01f);
+        ImGui::SliderFloat("Speed", &cfg.timeSpeed, -5.0f, 5.0f);
+        static const char* names[] = { "a", "b", "c", "d" };
+        for (int i = 0; i < 4; ++i) ImGui::SliderFloat(names[i], &cfg.params[i], -10.0f, 10.0f);
+        HelpMarker("Use t and a..d in f(x), e.g. a*sin(x - t).");
+        const ColumnEval& cols = scene.GetColumns();
+        if (scene.HasExprTree())
+            ImGui::TextDisabled("Last update recomputed %d of %d nodes", cols.recomputed(), cols.nodes());
+        else
+            ImGui::TextDisabled("Expression outside the tree subset: full re-evaluation on change");
+    }
+
+    if (ImGui::CollapsingHeader("Layers")) {
+        for (int k = 0; k < (int)cfg.layers.size(); ++k) {
+            PlotLayer& layer = cfg.layers[k];
+            ImGui::PushID(k);
+            ImGui::Checkbox("##visible", &layer.visible);
+            ImGui::SameLine();
+            ImGui::ColorEdit4("##color", (float*)&layer.color, ImGuiColorEditFlags_NoInputs);
+            ImGui::SameLine();
+            ImGui::InputTextWithHint("##expr", "e.g. cos(x)", layer.expr, AppConfig::kExprBufSize);
+            ImGui::SameLine();
+            const bool remove = ImGui::Button("x");
+            if (scene.LayerHasError(k))
+                ImGui::TextColored({ 1,0,0,1 }, "%s", scene.GetLayerError(k).c_str());
+            else if (scene.IsLayerCompiling(k))
+                ImGui::TextDisabled("Compiling...");
+            ImGui::PopID();
+            if (remove) {
+                cfg.layers.erase(cfg.layers.begin() + k);
+                scene.RemoveLayer(k);
+                --k;
+            }
+        }
+        if ((int)cfg.layers.size() < AppConfig::kMaxLayers && ImGui::Button("Add layer")) {
+            static const ImVec4 palette[] = {
+                { 0.90f, 0.30f, 0.20f, 1 }, { 0.20f, 0.65f, 0.30f, 1 }, { 0.60f, 0.35f, 0.80f, 1 },
+                { 0.95f, 0.60f, 0.10f, 1 }, { 0.10f, 0.70f, 0.75f, 1 }, { 0.55f, 0.55f, 0.55f, 1 },
+            };
+            PlotLayer layer;
+            layer.color = palette[cfg.layers.size() % (sizeof(palette) / sizeof(palette[0]))];
+            cfg.layers.push_back(layer);
+        }
+        HelpMarker("Extra functions drawn over f(x) on the same sample grid; a layer is resampled only when its own expression or a variable it uses changes.");
+    }
+
+    if (ImGui::CollapsingHeader("Export")) {
+        static const char* sizes[] = { "3840 (4k)", "7680 (8k)", "15360 (16k)" };
+        static const int widths[] = { 3840, 7680, 15360 };
+        int sel = 0;
+        while (sel < 2 && widths[sel] != m_exportWidth) ++sel;
+        if (ImGui::Combo("Width", &sel, sizes, IM_ARRAYSIZE(sizes))) m_exportWidth = widths[sel];
+        ImGui::InputText("File", m_exportPath, sizeof(m_exportPath));
+        if (ImGui::Button("Export PNG")) m_exportRequested = true;
+        HelpMarker("Renders grid, curves and the spectrum window on the CPU, tile by tile, at the chosen width.");
+        if (!m_exportStatus.empty()) ImGui::TextWrapped("%s", m_exportStatus.c_str());
+
+        ImGui::Separator();
+        ImGui::InputText("Recording", m_recordPath, sizeof(m_recordPath));
+        if (ImGui::Button(m_recording ? "Stop recording" : "Record input")) m_recordToggled = true;
+        HelpMarker("Captures wheel zoom, frame times and every panel edit to a compact file.\n"
+            "Replay it headless with fvbatch --replay to get per-frame cost percentiles.");
+        if (!m_recordStatus.empty()) ImGui::TextWrapped("%s", m_recordStatus.c_str());
+    }
+
+    if (ImGui::CollapsingHeader("Derivatives")) {
+        ImGui::Checkbox("f'(x)", &cfg.showDerivative1);
+        ImGui::SameLine();
+        ImGui::ColorEdit4("##d1color", (float*)&cfg.derivColor1, ImGuiColorEditFlags_NoInputs);
+        ImGui::Checkbox("f''(x)", &cfg.showDerivative2);
+        ImGui::SameLine();
+        ImGui::ColorEdit4("##d2color", (float*)&cfg.derivColor2, ImGuiColorEditFlags_NoInputs);
+        ImGui::Checkbox("Curvature refinement", &cfg.adaptiveCurve);
+        HelpMarker("Adds points to f(x) where |f''| makes straight segments visibly wrong.");
+        if (scene.HasExprTree())
+            ImGui::TextDisabled("Exact (forward-mode automatic differentiation)");
+        else
+            ImGui::TextDisabled("Approximate (finite differences of the samples)");
+    }
+
+    if (ImGui::CollapsingHeader("Annotations")) {
+        ImGui::Checkbox("Roots", &cfg.showRoots);
+        ImGui::SameLine();
+        ImGui::Checkbox("Extrema", &cfg.showExtrema);
+        ImGui::SameLine();
+        ImGui::Checkbox("Asymptotes", &cfg.showAsymptotes);
+        HelpMarker("Found from sign changes of the plotted samples, then refined with Brent's method.\n"
+            "Recomputed only when the expression or the view changes.");
+        ImGui::ColorEdit4("Marker color", (float*)&cfg.annotationColor);
+    }
+
+    if (ImGui::CollapsingHeader("Filter")) {
+        ImGui::Checkbox("Enable filter", &cfg.filterEnabled);
+        ImGui::BeginDisabled(!cfg.filterEnabled);
+
+        const char* types[] = { "Low-pass", "Band-pass", "Smoothing", "Kernel k(x)" };
+        ImGui::Combo("Filter type", &cfg.filterType, types, IM_ARRAYSIZE(types));
+        if (cfg.filterType == FILTER_BANDPASS)
+            ImGui::DragFloat("Low cutoff (rad/s)", &cfg.filterLow, 0.05f, 0.0f, cfg.filterHigh, "%.3f");
+        if (cfg.filterType == FILTER_LOWPASS || cfg.filterType == FILTER_BANDPASS)
+            ImGui::DragFloat("Cutoff (rad/s)", &cfg.filterHigh, 0.05f, cfg.filterLow, 1000.0f, "%.3f");
+        if (cfg.filterType == FILTER_KERNEL) {
+            ImGui::InputTextWithHint("k(x)", "e.g. exp(-x^2)", cfg.filterKernel, cfg.funcExprBufSize());
+            if (!scene.GetFilterError().empty()) ImGui::TextColored({ 1,0,0,1 }, "%s", scene.GetFilterError().c_str());
+        }
+        ImGui::DragFloat("Kernel width", &cfg.filterWidth, 0.01f, 0.01f, 100.0f, "%.3f");
+        HelpMarker("Support of the convolution kernel along x.\n"
+            "Wider kernels give sharper cutoffs and longer edge transients.\n"
+            "Convolution runs as FFT overlap-save, the kernel spectrum is cached until the filter changes.");
+        ImGui::ColorEdit4("Filtered color", (float*)&cfg.filterColor);
+        ImGui::EndDisabled();
+    }
+
+    if (ImGui::CollapsingHeader("Integral")) {
+        ImGui::Checkbox("Integrate f(x)", &cfg.quadEnabled);
+        ImGui::BeginDisabled(!cfg.quadEnabled);
+        ImGui::DragFloatRange2("Interval [a, b]", &cfg.quadA, &cfg.quadB, 0.01f, -1000.0f, 1000.0f, "%.3f");
+        HelpMarker("Adaptive Gauss-Kronrod (7/15), subintervals evaluated in parallel.\n"
+            "Dragging a bound only integrates the strip it moved across.");
+        ImGui::ColorEdit4("Area color", (float*)&cfg.quadColor);
+        ImGui::ColorEdit4("Area border", (float*)&cfg.quadBorderColor);
+        if (cfg.quadEnabled) {
+            const auto& q = scene.GetIntegral();
+            ImGui::Text("Integral: %.8g  (+/- %.2g)", q.value, q.error);
+            ImGui::Text("Evaluations (last update): %ld | Subintervals: %d", q.evals, q.intervals);
+        }
+        ImGui::EndDisabled();
+    }
+
+    if (ImGui::CollapsingHeader("Reconstruction")) {
+        ImGui::Checkbox("Top-K series", &cfg.reconEnabled);
+        ImGui::BeginDisabled(!cfg.reconEnabled);
+        ImGui::SliderInt("Terms (K)", &cfg.reconTerms, 1, cfg.samples / 2 + 1, "%d", ImGuiSliderFlags_Logarithmic);
+        HelpMarker("Rebuilds f(x) on the plotted grid from its K largest Fourier harmonics.\n"
+            "Watch convergence and Gibbs ringing at discontinuities as K grows.");
+        ImGui::ColorEdit4("Series color", (float*)&cfg.reconColor);
+        if (cfg.reconEnabled) {
+            const auto& rec = scene.GetReconstruction();
+            ImGui::Text("Energy captured: %.3f%% | RMS error: %.4g", rec.capturedEnergy() * 100.0, rec.rmsError());
+        }
+        ImGui::EndDisabled();
     }
 
     if (ImGui::CollapsingHeader("Fourier", ImGuiTreeNodeFlags_DefaultOpen)) {
@@ -65,7 +301,7 @@ void GuiManager::ShowMainMenu(AppConfig& cfg, Scene& scene) {
             "In a one-sided plot do not double k=0 or k=N/2.";
 
         HelpMarker(kFourierComponentHint);
-        const char* disp[] = { "Transform","Modulated signal" };
+        const char* disp[] = { "Transform","Modulated signal","Scalogram (CWT)","Power spectral density","Analytic signal (Hilbert)" };
         ImGui::Combo("Display", &cfg.fourierDisplayMode, disp, IM_ARRAYSIZE(disp));
             
         const char* comp[] = { "Magnitude", "Real","Imaginary" };
@@ -82,6 +318,35 @@ void GuiManager::ShowMainMenu(AppConfig& cfg, Scene& scene) {
             // Frequency range (± around center)
             ImGui::DragFloat("Range (Δk)", &cfg.fourierRange, 0.01f, 0.0f, (float)(cfg.samples / 2), "%.3f");
         }
+
+        if (cfg.fourierDisplayMode == FOURIER_SCALOGRAM) {
+            const char* wavelets[] = { "Morlet", "Mexican hat" };
+            ImGui::Combo("Wavelet", &cfg.cwtWavelet, wavelets, IM_ARRAYSIZE(wavelets));
+            ImGui::SliderInt("Scales", &cfg.cwtScales, 8, 256);
+            ImGui::DragFloatRange2("Band (rad/s)", &cfg.cwtFreqMin, &cfg.cwtFreqMax, 0.05f, 0.01f, 1000.0f, "%.2f");
+            HelpMarker("Wavelet scales are log-spaced across the band.\n"
+                "Each scale is one spectrum multiply and one inverse FFT, spread over all cores.");
+        }
+
+        if (cfg.fourierDisplayMode == FOURIER_PSD) {
+            ImGui::SliderInt("Segments", &cfg.psdSegments, 1, 64);
+            ImGui::SliderFloat("Overlap", &cfg.psdOverlap, 0.0f, 0.9f, "%.2f");
+            HelpMarker("Welch's method on the plotted curve: overlapping Hann-windowed segments\n"
+                "are transformed in parallel and their periodograms averaged.\n"
+                "More segments give a steadier estimate at a coarser frequency resolution.\n"
+                "The band is the 95% confidence interval of the average.");
+        }
+
+        if (cfg.fourierDisplayMode == FOURIER_ANALYTIC) {
+            const char* tracks[] = { "Envelope only", "Envelope + phase", "Envelope + frequency" };
+            ImGui::Combo("Track", &cfg.hilbertTrack, tracks, IM_ARRAYSIZE(tracks));
+            if (cfg.hilbertTrack != HILBERT_NONE) ImGui::ColorEdit4("Track color", (float*)&cfg.hilbertColor);
+            HelpMarker("Analytic signal of the plotted curve: one forward FFT, the negative frequencies\n"
+                "zeroed, one inverse FFT. The envelope |z| is drawn around the mean; the unwrapped\n"
+                "phase is scaled to span the envelope band and the frequency (rad per x unit) is its\n"
+                "slope between samples.\n"
+                "Recomputed only when the sampled curve changes.");
+        }
         ImGui::EndDisabled();
     }
 
@@ -97,8 +362,16 @@ void GuiManager::ShowMainMenu(AppConfig& cfg, Scene& scene) {
     if (ImGui::Button("Save")) cfg.Save("config.ini");
     ImGui::SameLine();
     if (ImGui::Button("Load")) cfg.Load("config.ini", scene);
+    ImGui::SameLine();
+    ImGui::Checkbox("Workspace snapshot", &cfg.workspaceSnapshot);
+    HelpMarker("On exit, also saves the sampled curve, layers and spectrum to workspace.fvs.\n"
+        "The next launch maps it and draws the first frame from it instead of recomputing.");
 
     ImGui::Separator();
     ImGui::Text("FPS %.3f ms/frame (%.1f F/s)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+    if (!m_startup.empty()) {
+        ImGui::TextDisabled("%s", m_startup.c_str());
+        HelpMarker(m_startupPhases.c_str());
+    }
     ImGui::End();
 }
\ No newline at end of file
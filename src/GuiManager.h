@@ -2,14 +2,36 @@
 #include "RendererDX9.h"
 #include "Scene.h"
 #include <imgui/imgui.h>
+#include <string>
 
 class GuiManager {
 public:
-    void Init(HWND hwnd, RendererDX9& renderer);
+    // fonts: a prebuilt atlas shared with the context (the caller keeps it alive), null = ImGui's own
+    void Init(HWND hwnd, RendererDX9& renderer, ImFontAtlas* fonts = nullptr);
     void Shutdown();
 
     void BeginFrame();
     void EndFrame(RendererDX9& renderer);
 
     void ShowMainMenu(AppConfig& cfg, Scene& scene);
+
+    // PNG export asked for in the panel; App runs it after the frame is presented
+    bool TakeExportRequest(int& width, std::string& path);
+    void SetExportStatus(const std::string& status) { m_exportStatus = status; }
+    // input recording started or stopped in the panel; App owns the recorder
+    bool TakeRecordToggle(std::string& path);
+    void SetRecording(bool on, const std::string& status) { m_recording = on; m_recordStatus = status; }
+    // time to first frame, with the per-phase breakdown as its tooltip
+    void SetStartupReport(const std::string& summary, const std::string& phases) { m_startup = summary; m_startupPhases = phases; }
+
+private:
+    bool m_exportRequested = false;
+    int  m_exportWidth = 7680;
+    char m_exportPath[260] = "plot.png";
+    std::string m_exportStatus;
+    bool m_recordToggled = false;
+    bool m_recording = false;
+    char m_recordPath[260] = "session.fvr";
+    std::string m_recordStatus;
+    std::string m_startup, m_startupPhases;
 };
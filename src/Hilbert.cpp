@@ -0,0 +1,61 @@
+#include "Hilbert.h"
+#include "FFT.h"
+#include <cmath>
+#include <algorithm>
+
+void AnalyticSignal::compute(const std::vector<double>& x, unsigned signalId, double dt) {
+    const int N = (int)x.size();
+    if (N < 2 || dt <= 0.0) {
+        envelope_.clear();
+        phase_.clear();
+        phaseTrack_.clear();
+        freq_.clear();
+        signalId_ = ~0u;
+        return;
+    }
+    if (signalId == signalId_ && N == length() && dt == dt_) return;
+    signalId_ = signalId;
+    dt_ = dt;
+
+    mean_ = 0.0;
+    for (double v : x) mean_ += v;
+    mean_ /= N;
+    z_.resize(N);
+    for (int n = 0; n < N; ++n) z_[n] = x[n] - mean_;
+
+    // one-sided spectrum: DC and Nyquist kept, positive bins doubled, negative zeroed
+    const FFT fft(N);
+    fft.forward(z_);
+    const int half = (N + 1) / 2;   // first bin past the positive ones (odd N has no Nyquist)
+    for (int k = 1; k < half; ++k) z_[k] *= 2.0;
+    for (int k = N / 2 + 1; k < N; ++k) z_[k] = 0.0;
+    fft.inverse(z_);
+
+    envelope_.resize(N);
+    phase_.resize(N);
+    freq_.resize(N);
+    double offset = 0.0;
+    for (int n = 0; n < N; ++n) {
+        envelope_[n] = std::abs(z_[n]);
+        const double p = std::arg(z_[n]);
+        if (n > 0) {
+            const double prev = phase_[n - 1] - offset;
+            if (p - prev > M_PI) offset -= 2.0 * M_PI;
+            else if (p - prev < -M_PI) offset += 2.0 * M_PI;
+        }
+        phase_[n] = p + offset;
+    }
+    // display copy of the phase: its range stretched over the envelope band
+    const auto [lo, hi] = std::minmax_element(phase_.begin(), phase_.end());
+    const double band = *std::max_element(envelope_.begin(), envelope_.end());
+    const double span = *hi - *lo;
+    phaseTrack_.resize(N);
+    for (int n = 0; n < N; ++n)
+        phaseTrack_[n] = mean_ + (span > 0.0 ? band * (2.0 * (phase_[n] - *lo) / span - 1.0) : 0.0);
+
+    // angle of z[n+1] conj(z[n-1]) is the phase step, wrapped into (-pi, pi]
+    for (int n = 0; n < N; ++n) {
+        const int a = n > 0 ? n - 1 : 0, b = n + 1 < N ? n + 1 : N - 1;
+        freq_[n] = std::arg(z_[b] * std::conj(z_[a])) / ((b - a) * dt);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include <complex>
+
+// Second curve drawn next to the envelope in the analytic-signal view
+enum HilbertTrack {
+    HILBERT_NONE = 0,
+    HILBERT_PHASE,          // unwrapped instantaneous phase, scaled into the envelope band
+    HILBERT_FREQUENCY,      // instantaneous frequency, rad per x unit
+};
+
+// Analytic signal z = x + i H{x} of uniformly spaced samples, through one
+// forward and one inverse FFT: the negative-frequency half of the spectrum is
+// zeroed and the positive half doubled. The mean is removed first, so the
+// envelope is |z| around it. Recomputed only when the signal id, length or
+// spacing changes; buffers are kept between calls.
+class AnalyticSignal {
+public:
+    void compute(const std::vector<double>& x, unsigned signalId, double dt);
+
+    int length() const { return (int)envelope_.size(); }
+    double mean() const { return mean_; }
+    // |z|
+    const std::vector<double>& envelope() const { return envelope_; }
+    // arg z, unwrapped
+    const std::vector<double>& phase() const { return phase_; }
+    // the unwrapped phase mapped linearly onto mean +- max |z|, so it stays
+    // in view next to the envelope however many cycles it covers
+    const std::vector<double>& phaseTrack() const { return phaseTrack_; }
+    // d(arg z)/dx from neighbouring samples, no unwrapping needed
+    const std::vector<double>& frequency() const { return freq_; }
+
+private:
+    unsigned signalId_ = ~0u;
+    double dt_ = 0.0;
+    double mean_ = 0.0;
+    std::vector<std::complex<double>> z_;
+    std::vector<double> envelope_, phase_, phaseTrack_, freq_;
+};
@@ -0,0 +1,266 @@
+#include "InputRecord.h"
+#include "Config.h"
+#include "Scene.h"
+#include "Timing.h"
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+using Clock = std::chrono::steady_clock;
+
+enum FrameFlags : uint8_t {
+    FRAME_WHEEL = 1,
+    FRAME_RESET = 2,
+    FRAME_SIZE = 4,
+    FRAME_CONFIG = 8,
+    FRAME_LAYERS = 16,
+};
+
+// ---------- file ----------
+template <class T> static void Put(std::ostream& os, T v) { os.write((const char*)&v, sizeof(v)); }
+template <class T> static bool Get(std::istream& is, T& v) { return (bool)is.read((char*)&v, sizeof(v)); }
+
+static void PutText(std::ostream& os, const std::string& s) {
+    Put(os, (uint32_t)s.size());
+    os.write(s.data(), s.size());
+}
+
+static bool GetText(std::istream& is, std::string& s) {
+    uint32_t n;
+    if (!Get(is, n) || n > (1u << 24)) return false;
+    s.resize(n);
+    return (bool)is.read(s.data(), n);
+}
+
+bool InputRecording::save(const std::string& path, std::string& error) const {
+    std::ofstream f(path, std::ios::out | std::ios::binary);
+    if (!f.is_open()) { error = "Cannot write " + path; return false; }
+    f.write("FVR1", 4);
+    Put(f, zoom.zoomExp);
+    Put(f, zoom.targetExp);
+    Put(f, zoom.expVel);
+    PutText(f, initialConfig);
+    Put(f, (uint32_t)frames.size());
+    ImVec2 size;
+    for (const InputFrame& fr : frames) {
+        uint8_t flags = 0;
+        if (fr.wheel != 0.0f) flags |= FRAME_WHEEL;
+        if (fr.resetZoom) flags |= FRAME_RESET;
+        if (fr.displaySize.x != size.x || fr.displaySize.y != size.y) flags |= FRAME_SIZE;
+        if (!fr.config.empty() || fr.layersChanged) flags |= FRAME_CONFIG;
+        if (fr.layersChanged) flags |= FRAME_LAYERS;
+        Put(f, fr.dt);
+        Put(f, flags);
+        if (flags & FRAME_WHEEL) Put(f, fr.wheel);
+        if (flags & FRAME_SIZE) { Put(f, fr.displaySize.x); Put(f, fr.displaySize.y); }
+        if (flags & FRAME_CONFIG) PutText(f, fr.config);
+        size = fr.displaySize;
+    }
+    f.flush();
+    if (!f) { error = "Cannot write " + path; return false; }
+    return true;
+}
+
+bool InputRecording::load(const std::string& path, std::string& error) {
+    std::ifstream f(path, std::ios::in | std::ios::binary);
+    if (!f.is_open()) { error = "Cannot open " + path; return false; }
+    char magic[4];
+    uint32_t count;
+    if (!f.read(magic, 4) || std::memcmp(magic, "FVR1", 4) != 0) { error = path + ": not a recording"; return false; }
+    if (!Get(f, zoom.zoomExp) || !Get(f, zoom.targetExp) || !Get(f, zoom.expVel) ||
+        !GetText(f, initialConfig) || !Get(f, count)) {
+        error = path + ": truncated header";
+        return false;
+    }
+    frames.clear();
+    frames.reserve(std::min<uint32_t>(count, 1u << 20));
+    ImVec2 size;
+    for (uint32_t i = 0; i < count; ++i) {
+        InputFrame fr;
+        uint8_t flags;
+        bool ok = Get(f, fr.dt) && Get(f, flags);
+        if (ok && (flags & FRAME_WHEEL)) ok = Get(f, fr.wheel);
+        if (ok && (flags & FRAME_SIZE)) ok = Get(f, size.x) && Get(f, size.y);
+        if (ok && (flags & FRAME_CONFIG)) ok = GetText(f, fr.config);
+        if (!ok) { error = path + ": truncated at frame " + std::to_string(i); return false; }
+        fr.resetZoom = (flags & FRAME_RESET) != 0;
+        fr.layersChanged = (flags & FRAME_LAYERS) != 0;
+        fr.displaySize = size;
+        frames.push_back(std::move(fr));
+    }
+    return true;
+}
+
+// ---------- recorder ----------
+static std::string ConfigText(const AppConfig& cfg) {
+    std::ostringstream os;
+    cfg.Write(os);
+    return os.str();
+}
+
+// lines of `after` that differ from `before`; layer lines are positional, so
+// they are all emitted when any of them changed
+static std::string DiffConfig(const std::string& before, const std::string& after, bool& layersChanged) {
+    auto split = [](const std::string& text, std::vector<std::string>& keyed, std::vector<std::string>& layers) {
+        std::istringstream is(text);
+        std::string line;
+        std::getline(is, line);   // header
+        while (std::getline(is, line))
+            (line.rfind("layer ", 0) == 0 ? layers : keyed).push_back(line);
+    };
+    std::vector<std::string> keyedA, layersA, keyedB, layersB;
+    split(before, keyedA, layersA);
+    split(after, keyedB, layersB);
+
+    std::string out;
+    // Write emits the keys in a fixed order, so non-layer lines pair up by index
+    for (size_t i = 0; i < keyedB.size(); ++i)
+        if (i >= keyedA.size() || keyedA[i] != keyedB[i]) out += keyedB[i] + "\n";
+    layersChanged = layersA != layersB;
+    if (layersChanged)
+        for (const std::string& line : layersB) out += line + "\n";
+    return out;
+}
+
+void InputRecorder::start(const AppConfig& cfg, const ZoomSpring& zoom) {
+    rec_ = InputRecording();
+    rec_.initialConfig = ConfigText(cfg);
+    rec_.zoom = zoom;
+    active_ = true;
+}
+
+bool InputRecorder::stop(const std::string& path, std::string& error) {
+    active_ = false;
+    const bool ok = path.empty() || rec_.save(path, error);
+    rec_ = InputRecording();
+    return ok;
+}
+
+void InputRecorder::frameInput(float dt, float wheel, bool resetZoom, const ImVec2& displaySize) {
+    if (!active_) return;
+    InputFrame fr;
+    fr.dt = dt;
+    fr.wheel = wheel;
+    fr.resetZoom = resetZoom;
+    fr.displaySize = displaySize;
+    rec_.frames.push_back(std::move(fr));
+}
+
+void InputRecorder::beforeGui(const AppConfig& cfg) {
+    if (active_) before_ = ConfigText(cfg);
+}
+
+void InputRecorder::afterGui(const AppConfig& cfg) {
+    if (!active_ || rec_.frames.empty()) return;
+    InputFrame& fr = rec_.frames.back();
+    fr.config = DiffConfig(before_, ConfigText(cfg), fr.layersChanged);
+}
+
+// ---------- replay ----------
+ReplayResult ReplayRecording(const InputRecording& rec, const ReplayOptions& opt) {
+    ReplayResult r;
+    Scene scene;
+    AppConfig cfg;
+    {
+        std::istringstream is(rec.initialConfig);
+        std::string header;
+        std::getline(is, header);
+        if (header.rfind("AppConfig", 0) != 0) { r.error = "recording has no initial config"; return r; }
+        cfg.layers.clear();
+        cfg.ApplyKV(is, scene);
+    }
+    if (opt.budgetMs > 0.0f) cfg.evalBudgetMs = opt.budgetMs;
+    ZoomSpring zoom = rec.zoom;
+
+    // private context with a default font, as in the PNG export
+    ImGuiContext* prev = ImGui::GetCurrentContext();
+    auto atlas = std::make_unique<ImFontAtlas>();
+    atlas->AddFontDefault();
+    unsigned char* pixels = nullptr;
+    int texW = 0, texH = 0;
+    atlas->GetTexDataAsRGBA32(&pixels, &texW, &texH);
+    atlas->SetTexID((ImTextureID)(intptr_t)1);
+    ImGuiContext* ctx = ImGui::CreateContext(atlas.get());
+    ImGui::SetCurrentContext(ctx);
+    ImGui::GetIO().IniFilename = nullptr;
+
+    scene.FinishCompiling();
+    r.frames.reserve(rec.frames.size());
+    for (const InputFrame& fr : rec.frames) {
+        FrameCost cost;
+        const float dt = opt.step > 0.0f ? opt.step : fr.dt;
+        ImGuiIO& io = ImGui::GetIO();
+        io.DeltaTime = std::max(dt, 1e-4f);
+        io.DisplaySize = ImVec2(std::max(fr.displaySize.x, 1.0f), std::max(fr.displaySize.y, 1.0f));
+        const ImVec2 winSize = io.DisplaySize;
+        const ImVec2 center(winSize.x * 0.5f, winSize.y * 0.5f);
+
+        // same order as App::Run
+        const auto t0 = Clock::now();
+        ImGui::NewFrame();
+        if (fr.wheel != 0.0f) zoom.Wheel(fr.wheel);
+        if (fr.resetZoom) zoom.Home();
+        cfg.gridScale = (int)zoom.Update(dt);
+        if (cfg.animate) cfg.time += dt * cfg.timeSpeed;
+        if (fr.layersChanged) cfg.layers.clear();
+        if (!fr.config.empty()) {
+            std::istringstream is(fr.config);
+            cfg.ApplyKV(is, scene);
+            if (opt.budgetMs > 0.0f) cfg.evalBudgetMs = opt.budgetMs;
+        }
+        cost.inputMs = MsSince(t0);
+
+        auto t1 = Clock::now();
+        scene.DrawBackground(winSize, cfg);
+        scene.DrawFunction(center, winSize, cfg);
+        cost.curveMs = MsSince(t1);
+
+        t1 = Clock::now();
+        if (cfg.fourierFunction) scene.DrawFourierTransform(center, winSize, cfg);
+        cost.spectrumMs = MsSince(t1);
+
+        t1 = Clock::now();
+        ImGui::Render();
+        cost.renderMs = MsSince(t1);
+        cost.totalMs = MsSince(t0);
+        r.frames.push_back(cost);
+
+        // outside the frame, every frame: whatever this frame requested is
+        // installed before the next one, however fast the compile was
+        const bool waiting = scene.IsCompiling() || scene.GetCache().Busy();
+        t1 = Clock::now();
+        scene.FinishCompiling();
+        if (waiting) {
+            r.compileMs += MsSince(t1);
+            ++r.compiles;
+        }
+    }
+
+    ImGui::DestroyContext(ctx);
+    ImGui::SetCurrentContext(prev);
+    r.ok = true;
+    return r;
+}
+
+CostSummary Summarize(const std::vector<FrameCost>& frames, double FrameCost::* field) {
+    CostSummary s;
+    if (frames.empty()) return s;
+    std::vector<double> v;
+    v.reserve(frames.size());
+    for (const FrameCost& f : frames) v.push_back(f.*field);
+    std::sort(v.begin(), v.end());
+    double sum = 0.0;
+    for (double x : v) sum += x;
+    // nearest-rank percentiles
+    auto pct = [&](double p) { return v[std::min(v.size() - 1, (size_t)(p * v.size()))]; };
+    s.mean = sum / v.size();
+    s.p50 = pct(0.50);
+    s.p90 = pct(0.90);
+    s.p99 = pct(0.99);
+    s.max = v.back();
+    return s;
+}
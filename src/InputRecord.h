@@ -0,0 +1,86 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <imgui/imgui.h>
+#include "Animation.h"
+
+class Scene;
+struct AppConfig;
+
+// One frame of interaction as App::Run sees it: input first, then whatever
+// the panel changed in the config during that frame
+struct InputFrame {
+    float  dt = 0.0f;
+    float  wheel = 0.0f;
+    bool   resetZoom = false;          // R held
+    ImVec2 displaySize;
+    bool   layersChanged = false;      // cfg.layers is replaced by the layer lines of `config`
+    std::string config;                // changed config.ini lines, applied with AppConfig::ApplyKV
+};
+
+// A recorded session: the state it started from and the frames after it.
+// File layout ("FVR1", little-endian), one record per frame:
+//   f32 dt, u8 flags, [f32 wheel], [f32 w, f32 h], [u32 len, config text]
+struct InputRecording {
+    std::string initialConfig;         // full config.ini text
+    ZoomSpring  zoom;                  // spring state at the first frame
+    std::vector<InputFrame> frames;
+
+    bool save(const std::string& path, std::string& error) const;
+    bool load(const std::string& path, std::string& error);
+};
+
+// Captures frames while active. Config mutations are found by diffing the
+// config text around ShowMainMenu, so the animation clock and the zoom
+// spring (replayed from their inputs) are not recorded as edits.
+class InputRecorder {
+public:
+    void start(const AppConfig& cfg, const ZoomSpring& zoom);
+    bool active() const { return active_; }
+    // stop and write the session; empty path discards it
+    bool stop(const std::string& path, std::string& error);
+    int  frames() const { return (int)rec_.frames.size(); }
+
+    void frameInput(float dt, float wheel, bool resetZoom, const ImVec2& displaySize);
+    void beforeGui(const AppConfig& cfg);
+    void afterGui(const AppConfig& cfg);
+
+private:
+    bool active_ = false;
+    InputRecording rec_;
+    std::string before_;
+};
+
+struct ReplayOptions {
+    float step = 1.0f / 60.0f;         // fixed timestep, 0 = the recorded frame times
+    float budgetMs = 60000.0f;         // evaluation budget, 0 = the recorded one (adapts N to timing)
+};
+
+// Cost of one replayed frame, milliseconds
+struct FrameCost {
+    double inputMs = 0.0;              // NewFrame, zoom spring, config edits
+    double curveMs = 0.0;              // DrawBackground + DrawFunction
+    double spectrumMs = 0.0;           // DrawFourierTransform
+    double renderMs = 0.0;             // ImGui::Render
+    double totalMs = 0.0;
+};
+
+struct ReplayResult {
+    bool ok = false;
+    std::string error;
+    std::vector<FrameCost> frames;
+    int    compiles = 0;               // frames that waited for a compile
+    double compileMs = 0.0;            // time spent waiting, not in any frame
+};
+
+// Re-run a session headless against a fresh Scene and a private ImGui
+// context. Compiles are waited for at the end of the frame that requested
+// them, so every run draws the same thing on the same frame.
+ReplayResult ReplayRecording(const InputRecording& rec, const ReplayOptions& opt);
+
+struct CostSummary {
+    double mean = 0.0, p50 = 0.0, p90 = 0.0, p99 = 0.0, max = 0.0;
+};
+
+// distribution of one FrameCost field over the frames
+CostSummary Summarize(const std::vector<FrameCost>& frames, double FrameCost::* field);
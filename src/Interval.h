@@ -0,0 +1,239 @@
+#pragma once
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+// Closed interval [lo, hi] with outward rounding. Evaluating an ExprTree over
+// Interval bounds f on a whole x-range at once. `singular` is set when f may
+// be discontinuous or partly undefined inside (division by an interval holding
+// zero, tan across a pole, floor across an integer, domain edges of log/sqrt).
+// An empty interval (lo > hi or NaN) means f is undefined on the entire range.
+struct Interval {
+    double lo = 0.0, hi = 0.0;
+    bool singular = false;
+
+    Interval() = default;
+    Interval(double v) : lo(v), hi(v) {}
+    Interval(double l, double h, bool s = false) : lo(l), hi(h), singular(s) {}
+
+    static Interval Empty() { return Interval(std::nan(""), std::nan(""), true); }
+    static Interval Entire(bool s = true) {
+        const double inf = std::numeric_limits<double>::infinity();
+        return Interval(-inf, inf, s);
+    }
+
+    bool empty() const { return !(lo <= hi); }
+    bool contains(double v) const { return lo <= v && v <= hi; }
+    double width() const { return hi - lo; }
+};
+
+namespace interval_detail {
+
+inline double down(double v) { return std::nextafter(v, -std::numeric_limits<double>::infinity()); }
+inline double up(double v) { return std::nextafter(v, std::numeric_limits<double>::infinity()); }
+
+// widen by one ulp each way to cover rounding of the libm result
+inline Interval outward(double lo, double hi, bool s) {
+    if (std::isnan(lo) || std::isnan(hi)) return Interval::Entire(true);
+    return Interval(down(lo), up(hi), s);
+}
+
+// true when phase + k*period lies in [lo, hi] for some integer k
+inline bool hits(double lo, double hi, double phase, double period) {
+    const double k = std::ceil((lo - phase) / period);
+    return phase + k * period <= hi;
+}
+
+// product bound where 0 * inf counts as 0
+inline double mul0(double a, double b) { return (a == 0.0 || b == 0.0) ? 0.0 : a * b; }
+
+inline Interval monotoneUp(const Interval& u, double (*f)(double)) {
+    return outward(f(u.lo), f(u.hi), u.singular);
+}
+
+} // namespace interval_detail
+
+inline Interval operator-(const Interval& a) { return Interval(-a.hi, -a.lo, a.singular); }
+inline Interval operator+(const Interval& a, const Interval& b) {
+    if (a.empty() || b.empty()) return Interval::Empty();
+    return interval_detail::outward(a.lo + b.lo, a.hi + b.hi, a.singular || b.singular);
+}
+inline Interval operator-(const Interval& a, const Interval& b) {
+    if (a.empty() || b.empty()) return Interval::Empty();
+    return interval_detail::outward(a.lo - b.hi, a.hi - b.lo, a.singular || b.singular);
+}
+inline Interval operator*(const Interval& a, const Interval& b) {
+    using interval_detail::mul0;
+    if (a.empty() || b.empty()) return Interval::Empty();
+    const double p[4] = { mul0(a.lo, b.lo), mul0(a.lo, b.hi), mul0(a.hi, b.lo), mul0(a.hi, b.hi) };
+    return interval_detail::outward(*std::min_element(p, p + 4), *std::max_element(p, p + 4),
+        a.singular || b.singular);
+}
+inline Interval operator/(const Interval& a, const Interval& b) {
+    if (a.empty() || b.empty()) return Interval::Empty();
+    if (b.contains(0.0)) {
+        if (b.lo == 0.0 && b.hi == 0.0) return Interval::Empty();
+        return Interval::Entire(true);
+    }
+    const Interval inv = interval_detail::outward(1.0 / b.hi, 1.0 / b.lo, b.singular);
+    return a * inv;
+}
+
+inline Interval sin(const Interval& u) {
+    using namespace interval_detail;
+    if (u.empty()) return u;
+    const double pi = 3.14159265358979323846;
+    if (!(u.width() < 2.0 * pi)) return Interval(-1.0, 1.0, u.singular);
+    const double a = std::sin(u.lo), b = std::sin(u.hi);
+    const double lo = hits(u.lo, u.hi, -0.5 * pi, 2.0 * pi) ? -1.0 : std::min(a, b);
+    const double hi = hits(u.lo, u.hi, 0.5 * pi, 2.0 * pi) ? 1.0 : std::max(a, b);
+    const Interval r = outward(lo, hi, u.singular);
+    return Interval(std::max(r.lo, -1.0), std::min(r.hi, 1.0), r.singular);
+}
+inline Interval cos(const Interval& u) {
+    using namespace interval_detail;
+    if (u.empty()) return u;
+    const double pi = 3.14159265358979323846;
+    if (!(u.width() < 2.0 * pi)) return Interval(-1.0, 1.0, u.singular);
+    const double a = std::cos(u.lo), b = std::cos(u.hi);
+    const double lo = hits(u.lo, u.hi, pi, 2.0 * pi) ? -1.0 : std::min(a, b);
+    const double hi = hits(u.lo, u.hi, 0.0, 2.0 * pi) ? 1.0 : std::max(a, b);
+    const Interval r = outward(lo, hi, u.singular);
+    return Interval(std::max(r.lo, -1.0), std::min(r.hi, 1.0), r.singular);
+}
+inline Interval tan(const Interval& u) {
+    using namespace interval_detail;
+    if (u.empty()) return u;
+    const double pi = 3.14159265358979323846;
+    if (!(u.width() < pi) || hits(u.lo, u.hi, 0.5 * pi, pi)) return Interval::Entire(true);
+    return outward(std::tan(u.lo), std::tan(u.hi), u.singular);
+}
+
+// clip u to [dlo, dhi]; partly outside marks the result singular
+inline Interval clipDomain(const Interval& u, double dlo, double dhi) {
+    if (u.empty() || u.hi < dlo || u.lo > dhi) return Interval::Empty();
+    const bool cut = u.lo < dlo || u.hi > dhi;
+    return Interval(std::max(u.lo, dlo), std::min(u.hi, dhi), u.singular || cut);
+}
+
+inline Interval asin(const Interval& u) {
+    const Interval c = clipDomain(u, -1.0, 1.0);
+    if (c.empty()) return c;
+    return interval_detail::monotoneUp(c, static_cast<double(*)(double)>(std::asin));
+}
+inline Interval acos(const Interval& u) {
+    const Interval c = clipDomain(u, -1.0, 1.0);
+    if (c.empty()) return c;
+    return interval_detail::outward(std::acos(c.hi), std::acos(c.lo), c.singular);
+}
+inline Interval atan(const Interval& u) {
+    if (u.empty()) return u;
+    return interval_detail::monotoneUp(u, static_cast<double(*)(double)>(std::atan));
+}
+inline Interval sinh(const Interval& u) {
+    if (u.empty()) return u;
+    return interval_detail::monotoneUp(u, static_cast<double(*)(double)>(std::sinh));
+}
+inline Interval cosh(const Interval& u) {
+    if (u.empty()) return u;
+    const double a = std::cosh(u.lo), b = std::cosh(u.hi);
+    const double lo = u.contains(0.0) ? 1.0 : std::min(a, b);
+    return interval_detail::outward(lo, std::max(a, b), u.singular);
+}
+inline Interval tanh(const Interval& u) {
+    if (u.empty()) return u;
+    return interval_detail::monotoneUp(u, static_cast<double(*)(double)>(std::tanh));
+}
+inline Interval exp(const Interval& u) {
+    if (u.empty()) return u;
+    const Interval r = interval_detail::monotoneUp(u, static_cast<double(*)(double)>(std::exp));
+    return Interval(std::max(r.lo, 0.0), r.hi, r.singular);
+}
+
+// log family: the left end runs to -inf when the range reaches zero
+inline Interval logLike(const Interval& u, double (*f)(double)) {
+    const Interval c = clipDomain(u, 0.0, std::numeric_limits<double>::infinity());
+    if (c.empty() || c.hi == 0.0) return Interval::Empty();
+    const double lo = c.lo > 0.0 ? f(c.lo) : -std::numeric_limits<double>::infinity();
+    return interval_detail::outward(lo, f(c.hi), c.singular || c.lo == 0.0);
+}
+inline Interval log(const Interval& u) { return logLike(u, static_cast<double(*)(double)>(std::log)); }
+inline Interval log10(const Interval& u) { return logLike(u, static_cast<double(*)(double)>(std::log10)); }
+inline Interval log2(const Interval& u) { return logLike(u, static_cast<double(*)(double)>(std::log2)); }
+
+inline Interval sqrt(const Interval& u) {
+    const Interval c = clipDomain(u, 0.0, std::numeric_limits<double>::infinity());
+    if (c.empty()) return c;
+    const Interval r = interval_detail::monotoneUp(c, static_cast<double(*)(double)>(std::sqrt));
+    return Interval(std::max(r.lo, 0.0), r.hi, r.singular);
+}
+inline Interval fabs(const Interval& u) {
+    if (u.empty()) return u;
+    if (u.lo >= 0.0) return u;
+    if (u.hi <= 0.0) return -u;
+    return Interval(0.0, std::max(-u.lo, u.hi), u.singular);
+}
+inline Interval floor(const Interval& u) {
+    if (u.empty()) return u;
+    const double a = std::floor(u.lo), b = std::floor(u.hi);
+    return Interval(a, b, u.singular || a != b);
+}
+inline Interval ceil(const Interval& u) {
+    if (u.empty()) return u;
+    const double a = std::ceil(u.lo), b = std::ceil(u.hi);
+    return Interval(a, b, u.singular || a != b);
+}
+inline Interval esgn(const Interval& u) {
+    if (u.empty()) return u;
+    const double a = u.lo > 0.0 ? 1.0 : (u.lo < 0.0 ? -1.0 : 0.0);
+    const double b = u.hi > 0.0 ? 1.0 : (u.hi < 0.0 ? -1.0 : 0.0);
+    return Interval(a, b, u.singular || a != b);
+}
+inline Interval emin(const Interval& a, const Interval& b) {
+    if (a.empty() || b.empty()) return Interval::Empty();
+    return Interval(std::min(a.lo, b.lo), std::min(a.hi, b.hi), a.singular || b.singular);
+}
+inline Interval emax(const Interval& a, const Interval& b) {
+    if (a.empty() || b.empty()) return Interval::Empty();
+    return Interval(std::max(a.lo, b.lo), std::max(a.hi, b.hi), a.singular || b.singular);
+}
+
+// fmod is exact inside one period of a constant divisor, otherwise it may jump
+inline Interval fmod(const Interval& a, const Interval& b) {
+    if (a.empty() || b.empty()) return Interval::Empty();
+    if (b.lo == b.hi && b.lo != 0.0 && std::isfinite(a.lo) && std::isfinite(a.hi)) {
+        const double q = std::trunc(a.lo / b.lo);
+        if (q == std::trunc(a.hi / b.lo) && (a.lo >= 0.0 || a.hi <= 0.0))
+            return interval_detail::outward(a.lo - q * b.lo, a.hi - q * b.lo, a.singular || b.singular);
+    }
+    const double m = std::max(std::fabs(b.lo), std::fabs(b.hi));
+    const double lo = a.lo >= 0.0 ? 0.0 : -m;
+    const double hi = a.hi <= 0.0 ? 0.0 : m;
+    return Interval(lo, hi, true);
+}
+
+// u^c for a constant exponent; integer powers accept negative bases like exprtk
+inline Interval epowc(const Interval& u, double c) {
+    using interval_detail::outward;
+    if (u.empty()) return u;
+    if (c == 0.0) return Interval(1.0, 1.0, u.singular);
+    if (c == std::floor(c) && std::fabs(c) < 1e9) {
+        if (c < 0.0) return Interval(1.0) / epowc(u, -c);
+        const bool even = std::fmod(c, 2.0) == 0.0;
+        const double a = std::pow(u.lo, c), b = std::pow(u.hi, c);
+        if (!even) return outward(a, b, u.singular);
+        if (u.contains(0.0)) return outward(0.0, std::max(a, b), u.singular);
+        return outward(std::min(a, b), std::max(a, b), u.singular);
+    }
+    const Interval d = clipDomain(u, 0.0, std::numeric_limits<double>::infinity());
+    if (d.empty()) return d;
+    if (c > 0.0) return outward(std::pow(d.lo, c), std::pow(d.hi, c), d.singular);
+    if (d.hi == 0.0) return Interval::Empty();
+    const double hi = d.lo > 0.0 ? std::pow(d.lo, c) : std::numeric_limits<double>::infinity();
+    return outward(std::pow(d.hi, c), hi, d.singular || d.lo == 0.0);
+}
+inline Interval pow(const Interval& a, const Interval& b) {
+    if (a.empty() || b.empty()) return Interval::Empty();
+    if (a.lo > 0.0) return exp(b * log(a));
+    return Interval::Entire(true);
+}
@@ -0,0 +1,102 @@
+#include "IntervalPlot.h"
+#include "Interval.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace {
+
+const double kFlatPx = 1.0;     // bound narrower than this is drawn as one segment
+const double kSpikePx = 1.0;    // allowed gap between bound and chord
+const double kMinPx = 0.5;      // smallest cell width
+
+class Tracer {
+public:
+    Tracer(const ExprTree& tree, const double* vars, int count, double yMin, double yMax,
+        double unit, double samplePx, int budget)
+        : tree_(tree), point_(vars, vars + count), range_(vars, vars + count),
+          yMin_(yMin), yMax_(yMax), unit_(unit), samplePx_(samplePx), budget_(budget) {}
+
+    double point(double x) {
+        ++stats.points;
+        point_[0] = x;
+        return tree_.eval(point_.data());
+    }
+
+    void cell(double a, double b, double fa, double fb) {
+        range_[0] = Interval(a, b);
+        const Interval r = tree_.eval(range_.data());
+        ++stats.cells;
+
+        if (r.empty() || r.hi < yMin_ || r.lo > yMax_) {
+            ++stats.culled;
+            cut();
+            return;
+        }
+        const double rangePx = (r.hi - r.lo) * unit_;
+        const double widthPx = (b - a) * unit_;
+        if (!r.singular && rangePx <= kFlatPx) {
+            ++stats.flat;
+            segment(a, b, fa, fb);
+            return;
+        }
+        if (widthPx <= kMinPx || stats.cells >= budget_) {
+            if (r.singular) { ++stats.breaks; cut(); }
+            else segment(a, b, fa, fb);
+            return;
+        }
+        const double chordPx = std::fabs(fb - fa) * unit_;
+        const bool split = widthPx > samplePx_ || r.singular || !(rangePx <= chordPx + kSpikePx);
+        if (!split) {
+            segment(a, b, fa, fb);
+            return;
+        }
+        const double m = 0.5 * (a + b);
+        const double fm = point(m);
+        cell(a, m, fa, fm);
+        cell(m, b, fm, fb);
+    }
+
+    std::vector<TracePoint> out;
+    TraceStats stats;
+
+private:
+    void segment(double a, double b, double fa, double fb) {
+        if (!std::isfinite(fa) || !std::isfinite(fb)) { cut(); return; }
+        if (!open_) out.push_back({ a, fa });
+        out.push_back({ b, fb });
+        open_ = true;
+    }
+    void cut() {
+        if (open_) out.push_back({ out.back().x, std::numeric_limits<double>::quiet_NaN() });
+        open_ = false;
+    }
+
+    const ExprTree& tree_;
+    std::vector<double> point_;
+    std::vector<Interval> range_;
+    double yMin_, yMax_, unit_, samplePx_;
+    int budget_;
+    bool open_ = false;
+};
+
+} // namespace
+
+std::vector<TracePoint> traceCurve(const ExprTree& tree, const double* vars, double xMin, double xMax,
+    double yMin, double yMax, double unit, int samples, TraceStats* stats)
+{
+    if (!tree.valid() || !(xMax > xMin)) return {};
+    samples = samples > 2 ? samples : 2;
+    const double samplePx = (xMax - xMin) * unit / (samples - 1);
+    // enough cells for every pixel column to split a few times, plus the sample grid
+    const int budget = 8 * int((xMax - xMin) * unit / kMinPx) + 2 * samples;
+
+    // one slot per variable the tree references
+    int count = 1;
+    for (const auto& n : tree.nodes()) if (n.op == ExprTree::OP_VAR) count = std::max(count, n.var + 1);
+
+    Tracer t(tree, vars, count, yMin, yMax, unit, samplePx, budget);
+    t.cell(xMin, xMax, t.point(xMin), t.point(xMax));
+    if (stats) *stats = t.stats;
+    return std::move(t.out);
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <vector>
+#include "ExprTree.h"
+
+struct TracePoint {
+    double x = 0.0;
+    double y = 0.0;     // NaN marks a break between connected pieces
+};
+
+struct TraceStats {
+    int cells = 0;      // interval evaluations
+    int points = 0;     // point evaluations
+    int culled = 0;     // cells proven off-screen or undefined
+    int flat = 0;       // cells proven to fit inside one pixel row
+    int breaks = 0;     // pixel-sized cells left unconnected at a singularity
+};
+
+// Trace y = f(x) over [xMin, xMax] by interval subdivision. A cell whose bound
+// lies outside [yMin, yMax] is skipped, a cell whose bound spans less than a
+// pixel is drawn as one segment, and cells that may hide a spike or a
+// singularity are split down to half a pixel. Elsewhere cells stop at the
+// sample spacing given by samples. unit is pixels per world unit. vars holds
+// the values of the tree's variables; slot 0 is x and gets overwritten.
+std::vector<TracePoint> traceCurve(const ExprTree& tree, const double* vars, double xMin, double xMax,
+    double yMin, double yMax, double unit, int samples, TraceStats* stats = nullptr);
@@ -0,0 +1,43 @@
+#include "LayerBlock.h"
+#include <algorithm>
+
+bool LayerBlock::setGrid(double xMin, double xMax, int n) {
+    if (n == n_ && xMin == xMin_ && xMax == xMax_) return false;
+    xMin_ = xMin;
+    xMax_ = xMax;
+    n_ = n;
+    // same float arithmetic as the f(x) curve so both land on identical pixels
+    xs_.resize(n);
+    for (int i = 0; i < n; ++i) {
+        const float t = float(i) / float(n - 1);
+        xs_[i] = float(xMin) + t * float(xMax - xMin);
+    }
+    data_.assign(size_t(layers_) * n, 0.0);
+    std::fill(dirty_.begin(), dirty_.end(), 1);
+    sxValid_ = false;
+    return true;
+}
+
+void LayerBlock::setLayers(int count) {
+    if (count == layers_) return;
+    data_.resize(size_t(count) * n_, 0.0);
+    dirty_.resize(count, 1);
+    layers_ = count;
+}
+
+void LayerBlock::erase(int k) {
+    data_.erase(data_.begin() + size_t(k) * n_, data_.begin() + size_t(k + 1) * n_);
+    dirty_.erase(dirty_.begin() + k);
+    --layers_;
+}
+
+const std::vector<float>& LayerBlock::screenX(float centerX, float unit) {
+    if (!sxValid_ || centerX != sxCenter_ || unit != sxUnit_) {
+        sx_.resize(n_);
+        for (int i = 0; i < n_; ++i) sx_[i] = centerX + float(xs_[i]) * unit;
+        sxCenter_ = centerX;
+        sxUnit_ = unit;
+        sxValid_ = true;
+    }
+    return sx_;
+}
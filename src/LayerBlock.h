@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+// Samples of several functions on one uniform x grid. All rows live in a single
+// block (row k = layer k, n values each) next to the grid and its screen
+// projection, which every layer shares. Each row has a dirty flag: changing
+// the grid marks all rows, changing one layer marks only its own row.
+class LayerBlock {
+public:
+    // Returns true when the grid changed and every row became dirty
+    bool setGrid(double xMin, double xMax, int n);
+    // Keeps the first rows, new ones start dirty
+    void setLayers(int count);
+    // Drops row k and shifts the rows after it down
+    void erase(int k);
+
+    void invalidate(int k) { dirty_[k] = 1; }
+    bool dirty(int k) const { return dirty_[k] != 0; }
+    // Row k for writing, marked clean
+    double* write(int k) { dirty_[k] = 0; return &data_[size_t(k) * n_]; }
+    const double* row(int k) const { return &data_[size_t(k) * n_]; }
+
+    int layers() const { return layers_; }
+    int samples() const { return n_; }
+    double x(int i) const { return xs_[i]; }
+
+    // Screen x of every grid point for x_s = centerX + x * unit, redone only
+    // when the grid or the mapping changes
+    const std::vector<float>& screenX(float centerX, float unit);
+
+private:
+    double xMin_ = 0.0, xMax_ = 0.0;
+    int n_ = 0;
+    int layers_ = 0;
+    std::vector<double> xs_;
+    std::vector<double> data_;
+    std::vector<unsigned char> dirty_;
+
+    std::vector<float> sx_;
+    float sxCenter_ = 0.0f, sxUnit_ = 0.0f;
+    bool sxValid_ = false;
+};
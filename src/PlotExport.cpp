@@ -0,0 +1,110 @@
+#include "PlotExport.h"
+#include "SoftRaster.h"
+#include "PngWriter.h"
+#include "Scene.h"
+#include "Config.h"
+#include <imgui/imgui_internal.h>
+#include <memory>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <filesystem>
+
+// largest glyph size baked for an export; beyond it labels are magnified
+static const float kMaxFontPixels = 160.0f;
+
+bool ExportPlotPng(Scene& scene, const AppConfig& cfg, const ImVec2& logicalSize, int width,
+    const std::string& path, std::string& error, const std::string& fontPath)
+{
+    if (logicalSize.x < 1.0f || logicalSize.y < 1.0f || width < 1) {
+        error = "Nothing to export";
+        return false;
+    }
+    const float scale = width / logicalSize.x;
+    const int height = std::max(1, (int)std::lround(logicalSize.y * scale));
+
+    // spectrum window where the live UI has it, a default spot otherwise
+    ImVec2 winPos(logicalSize.x * 0.55f, logicalSize.y * 0.55f);
+    ImVec2 winSize(logicalSize.x * 0.42f, 320.0f);
+    ImGuiContext* prev = ImGui::GetCurrentContext();
+    ImGuiStyle style;
+    float fontSize = 13.0f;   // ImGui's default font
+    if (prev) {
+        fontSize = ImGui::GetFontSize();
+        style = ImGui::GetStyle();
+        for (const char* name : { "Fourier Transform", "Scalogram", "Power Spectral Density" }) {
+            if (ImGuiWindow* w = ImGui::FindWindowByName(name)) {
+                winPos = w->Pos;
+                winSize = w->Size;
+                break;
+            }
+        }
+    }
+
+    // glyphs rasterized at the output size, drawn back at the logical size
+    const float fontPixels = std::min(fontSize * scale, kMaxFontPixels);
+    auto atlas = std::make_unique<ImFontAtlas>();
+    std::error_code ec;
+    ImFont* font = nullptr;
+    if (!fontPath.empty() && std::filesystem::exists(fontPath, ec))
+        font = atlas->AddFontFromFileTTF(fontPath.c_str(), fontPixels, nullptr, atlas->GetGlyphRangesCyrillic());
+    if (!font) {
+        ImFontConfig fc;
+        fc.SizePixels = fontPixels;
+        atlas->AddFontDefault(&fc);
+    }
+    unsigned char* pixels = nullptr;
+    int texW = 0, texH = 0;
+    atlas->GetTexDataAsRGBA32(&pixels, &texW, &texH);
+    atlas->SetTexID((ImTextureID)(intptr_t)1);   // any id the raster can match
+
+    ImGuiContext* ctx = ImGui::CreateContext(atlas.get());
+    ImGui::SetCurrentContext(ctx);
+    ImGui::GetStyle() = style;
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    io.FontGlobalScale = fontSize / fontPixels;
+    io.DisplaySize = logicalSize;
+    io.DeltaTime = 1.0f / 60.0f;
+
+    // print quality: at least one sample per two output pixels, and time to compute them
+    AppConfig out = cfg;
+    out.samples = std::max(cfg.samples, std::min(16384, width / 2));
+    out.evalBudgetMs = std::max(cfg.evalBudgetMs, 5000.0f);
+
+    // two frames: windows new to this context are laid out in the first, drawn in the second
+    const ImVec2 center(logicalSize.x * 0.5f, logicalSize.y * 0.5f);
+    for (int frame = 0; frame < 2; ++frame) {
+        ImGui::NewFrame();
+        // keep the anti-aliasing fringe one output pixel wide after scaling
+        ImGui::GetDrawListSharedData()->InitialFringeScale = 1.0f / scale;
+        ImGui::GetBackgroundDrawList()->_FringeScale = 1.0f / scale;
+
+        scene.DrawBackground(logicalSize, out);
+        scene.DrawFunction(center, logicalSize, out);
+        if (out.fourierFunction) {
+            ImGui::SetNextWindowPos(winPos, ImGuiCond_Always);
+            ImGui::SetNextWindowSize(winSize, ImGuiCond_Always);
+            scene.DrawFourierTransform(center, logicalSize, out);
+        }
+        ImGui::Render();
+    }
+
+    // opaque background, the way the renderer clears the screen
+    const ImVec4& bg = cfg.backgroundColor;
+    const ImVec4 clear(bg.x * bg.w, bg.y * bg.w, bg.z * bg.w, 1.0f);
+    RasterTexture tex;
+    tex.id = atlas->TexID;
+    tex.rgba = pixels;
+    tex.width = texW;
+    tex.height = texH;
+
+    PngWriter png;
+    bool ok = png.open(path, width, height) &&
+        RasterizeDrawData(*ImGui::GetDrawData(), scale, tex, clear, png);
+    if (!ok) error = png.error().empty() ? "Export failed" : png.error();
+
+    ImGui::DestroyContext(ctx);
+    ImGui::SetCurrentContext(prev);
+    return ok;
+}
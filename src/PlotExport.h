@@ -0,0 +1,16 @@
+#pragma once
+#include <string>
+#include <imgui/imgui.h>
+
+class Scene;
+struct AppConfig;
+
+// Draws the plot once more (grid, f(x) and layers, the spectrum window) in a
+// private ImGui context and rasterizes it on the CPU into a PNG `width`
+// pixels wide with the aspect of `logicalSize`. Needs no GPU or window:
+// with a live ImGui context the style, font size and spectrum window
+// placement are taken from it. Labels come from an atlas baked at the output
+// scale from fontPath (ImGui's default font when empty or missing), so text
+// stays sharp at 8k and 16k.
+bool ExportPlotPng(Scene& scene, const AppConfig& cfg, const ImVec2& logicalSize, int width,
+    const std::string& path, std::string& error, const std::string& fontPath = std::string());
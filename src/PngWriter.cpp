@@ -0,0 +1,225 @@
+#include "PngWriter.h"
+#include <cstring>
+#include <algorithm>
+
+namespace {
+
+const int kWindow = 32768;
+const int kHashBits = 15;
+const int kMaxChain = 16;
+const int kMinMatch = 3, kMaxMatch = 258;
+
+const uint16_t kLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+const uint8_t kLengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+const uint16_t kDistBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+const uint8_t kDistExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+uint32_t Crc32(uint32_t crc, const uint8_t* p, size_t n) {
+    static uint32_t table[256];
+    static const bool init = [] {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        return true;
+    }();
+    (void)init;
+    crc = ~crc;
+    for (size_t i = 0; i < n; ++i) crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+void PutBE32(uint8_t* p, uint32_t v) {
+    p[0] = uint8_t(v >> 24); p[1] = uint8_t(v >> 16); p[2] = uint8_t(v >> 8); p[3] = uint8_t(v);
+}
+
+inline uint32_t Hash3(const uint8_t* p) {
+    const uint32_t v = uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16;
+    return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+} // namespace
+
+PngWriter::~PngWriter() {
+    if (file_) std::fclose(file_);
+}
+
+bool PngWriter::fail(const std::string& what) {
+    if (error_.empty()) error_ = what;
+    if (file_) { std::fclose(file_); file_ = nullptr; }
+    return false;
+}
+
+bool PngWriter::open(const std::string& path, int width, int height) {
+    if (width <= 0 || height <= 0) return fail("empty image");
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) return fail("cannot create " + path);
+    width_ = width;
+    height_ = height;
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::fwrite(signature, 1, 8, file_);
+    uint8_t ihdr[13];
+    PutBE32(ihdr, uint32_t(width));
+    PutBE32(ihdr + 4, uint32_t(height));
+    ihdr[8] = 8;    // bit depth
+    ihdr[9] = 6;    // RGBA
+    ihdr[10] = ihdr[11] = ihdr[12] = 0;   // deflate, adaptive filtering, no interlace
+    if (!chunk("IHDR", ihdr, sizeof(ihdr))) return false;
+
+    // zlib header: deflate, 32K window, no dictionary
+    out_ = { 0x78, 0x01 };
+    head_.assign(size_t(1) << kHashBits, -1);
+    prev_.assign(kWindow, -1);
+    return true;
+}
+
+bool PngWriter::chunk(const char* type, const uint8_t* data, size_t size) {
+    uint8_t header[8];
+    PutBE32(header, uint32_t(size));
+    std::memcpy(header + 4, type, 4);
+    uint32_t crc = Crc32(0, header + 4, 4);
+    crc = Crc32(crc, data, size);
+    uint8_t tail[4];
+    PutBE32(tail, crc);
+    if (std::fwrite(header, 1, 8, file_) != 8 ||
+        (size && std::fwrite(data, 1, size, file_) != size) ||
+        std::fwrite(tail, 1, 4, file_) != 4)
+        return fail("write error");
+    return true;
+}
+
+void PngWriter::putBits(uint32_t bits, int count) {
+    bitBuf_ |= uint64_t(bits) << bitCount_;
+    bitCount_ += count;
+    while (bitCount_ >= 8) {
+        out_.push_back(uint8_t(bitBuf_));
+        bitBuf_ >>= 8;
+        bitCount_ -= 8;
+    }
+}
+
+void PngWriter::putHuffman(uint32_t code, int length) {
+    uint32_t rev = 0;
+    for (int i = 0; i < length; ++i) rev |= ((code >> i) & 1u) << (length - 1 - i);
+    putBits(rev, length);
+}
+
+// Fixed literal/length code (RFC 1951, 3.2.6)
+void PngWriter::literal(int v) {
+    if (v < 144) putHuffman(0x30 + v, 8);
+    else if (v < 256) putHuffman(0x190 + (v - 144), 9);
+    else if (v < 280) putHuffman(v - 256, 7);
+    else putHuffman(0xC0 + (v - 280), 8);
+}
+
+void PngWriter::match(int length, int distance) {
+    int l = 28;
+    while (kLengthBase[l] > length) --l;
+    literal(257 + l);
+    if (kLengthExtra[l]) putBits(uint32_t(length - kLengthBase[l]), kLengthExtra[l]);
+    int d = 29;
+    while (kDistBase[d] > distance) --d;
+    putHuffman(uint32_t(d), 5);
+    if (kDistExtra[d]) putBits(uint32_t(distance - kDistBase[d]), kDistExtra[d]);
+}
+
+// One fixed-Huffman block per band; matches stay inside the band
+void PngWriter::deflateBand(const uint8_t* data, size_t size) {
+    putBits(0, 1);   // BFINAL = 0
+    putBits(1, 2);   // BTYPE = fixed Huffman
+    std::fill(head_.begin(), head_.end(), -1);
+
+    size_t i = 0;
+    while (i < size) {
+        int bestLen = 0, bestDist = 0;
+        if (i + kMinMatch <= size) {
+            const uint32_t h = Hash3(data + i);
+            const int maxLen = (int)std::min<size_t>(kMaxMatch, size - i);
+            int cand = head_[h];
+            for (int chain = 0; cand >= 0 && chain < kMaxChain; ++chain) {
+                const int dist = int(i) - cand;
+                if (dist > kWindow) break;
+                int len = 0;
+                while (len < maxLen && data[cand + len] == data[i + len]) ++len;
+                if (len > bestLen) {
+                    bestLen = len;
+                    bestDist = dist;
+                    if (len == maxLen) break;
+                }
+                const int next = prev_[cand & (kWindow - 1)];
+                if (next >= cand) break;   // slot reused by a newer position
+                cand = next;
+            }
+        }
+        const size_t step = bestLen >= kMinMatch ? size_t(bestLen) : 1;
+        if (bestLen >= kMinMatch) match(bestLen, bestDist);
+        else literal(data[i]);
+
+        // index every position the step covered
+        for (size_t k = i; k < i + step && k + kMinMatch <= size; ++k) {
+            const uint32_t h = Hash3(data + k);
+            prev_[k & (kWindow - 1)] = head_[h];
+            head_[h] = int32_t(k);
+        }
+        i += step;
+    }
+    literal(256);   // end of block
+}
+
+bool PngWriter::writeRows(const uint8_t* rgba, int rows) {
+    if (!file_) return false;
+    if (rows <= 0) return true;
+    if (rowsWritten_ + rows > height_) return fail("too many rows");
+
+    // Sub filter: flat background turns into runs of zeros
+    const size_t stride = size_t(width_) * 4;
+    filtered_.resize(size_t(rows) * (stride + 1));
+    uint8_t* dst = filtered_.data();
+    for (int y = 0; y < rows; ++y) {
+        const uint8_t* src = rgba + size_t(y) * stride;
+        *dst++ = 1;
+        for (size_t k = 0; k < 4 && k < stride; ++k) *dst++ = src[k];
+        for (size_t k = 4; k < stride; ++k) *dst++ = uint8_t(src[k] - src[k - 4]);
+    }
+
+    // Adler-32 of the uncompressed stream, reduced often enough not to overflow
+    for (size_t i = 0; i < filtered_.size();) {
+        const size_t end = std::min(filtered_.size(), i + 5552);
+        for (; i < end; ++i) { adlerA_ += filtered_[i]; adlerB_ += adlerA_; }
+        adlerA_ %= 65521;
+        adlerB_ %= 65521;
+    }
+
+    deflateBand(filtered_.data(), filtered_.size());
+    rowsWritten_ += rows;
+    if (!chunk("IDAT", out_.data(), out_.size())) return false;
+    out_.clear();
+    return true;
+}
+
+bool PngWriter::close() {
+    if (!file_) return false;
+    if (rowsWritten_ != height_) return fail("image incomplete");
+
+    // empty final block, byte align, Adler-32
+    putBits(1, 1);
+    putBits(1, 2);
+    literal(256);
+    if (bitCount_ > 0) putBits(0, 8 - bitCount_);
+    const uint32_t adler = (adlerB_ << 16) | adlerA_;
+    uint8_t tail[4];
+    PutBE32(tail, adler);
+    out_.insert(out_.end(), tail, tail + 4);
+
+    if (!chunk("IDAT", out_.data(), out_.size())) return false;
+    if (!chunk("IEND", nullptr, 0)) return false;
+    const bool ok = std::fclose(file_) == 0;
+    file_ = nullptr;
+    return ok || fail("write error");
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Streaming RGBA8 PNG encoder. Rows are handed over in bands, top to bottom;
+// each band is filtered, deflated and written as its own IDAT chunk, so
+// memory use follows the band size, not the image size. Compression is
+// LZ77 with the fixed Huffman code: no tables to build, and plots (flat
+// background, thin lines) still shrink by an order of magnitude.
+class PngWriter {
+public:
+    PngWriter() = default;
+    ~PngWriter();
+
+    PngWriter(const PngWriter&) = delete;
+    PngWriter& operator=(const PngWriter&) = delete;
+
+    bool open(const std::string& path, int width, int height);
+    // rows * width * 4 bytes, continuing where the previous band ended
+    bool writeRows(const uint8_t* rgba, int rows);
+    // Ends the zlib stream and the file; fails unless all rows were written
+    bool close();
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    const std::string& error() const { return error_; }
+
+private:
+    void putBits(uint32_t bits, int count);
+    void putHuffman(uint32_t code, int length);   // code MSB first, as deflate wants
+    void literal(int value);
+    void match(int length, int distance);
+    void deflateBand(const uint8_t* data, size_t size);
+    bool chunk(const char* type, const uint8_t* data, size_t size);
+    bool fail(const std::string& what);
+
+    std::FILE* file_ = nullptr;
+    int width_ = 0, height_ = 0, rowsWritten_ = 0;
+    std::string error_;
+
+    std::vector<uint8_t> filtered_;   // current band with a filter byte per row
+    std::vector<uint8_t> out_;        // compressed bytes not yet in an IDAT
+    uint64_t bitBuf_ = 0;
+    int bitCount_ = 0;
+    uint32_t adlerA_ = 1, adlerB_ = 0;
+
+    std::vector<int32_t> head_, prev_;   // LZ77 hash chains
+};
@@ -0,0 +1,112 @@
+#include "Quadrature.h"
+#include "ThreadPool.h"
+#include <cmath>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+// Kronrod abscissae (positive half) and weights; odd indices are the 7-point Gauss nodes
+static const double kXgk[8] = {
+    0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+    0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+    0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+    0.207784955007898467600689403773245, 0.000000000000000000000000000000000 };
+static const double kWgk[8] = {
+    0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+    0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+    0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+    0.204432940075298892414161999234649, 0.209482141084727828012999174891714 };
+static const double kWg[4] = {
+    0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+    0.381830050505118944950369775488975, 0.417959183673469387755102040816327 };
+
+struct Segment {
+    double a, b;
+    double value = 0.0;
+    double error = 0.0;
+};
+
+// 15-point Kronrod estimate with the embedded 7-point Gauss rule as error reference
+static void gk15(const std::function<double(int, double)>& f, int slot, Segment& s) {
+    const double c = 0.5 * (s.a + s.b);
+    const double h = 0.5 * (s.b - s.a);
+    const double fc = f(slot, c);
+    double k = fc * kWgk[7];
+    double g = fc * kWg[3];
+    for (int j = 0; j < 7; ++j) {
+        const double dx = h * kXgk[j];
+        const double sum = f(slot, c - dx) + f(slot, c + dx);
+        k += kWgk[j] * sum;
+        if (j % 2 == 1) g += kWg[j / 2] * sum;
+    }
+    s.value = k * h;
+    s.error = std::fabs((k - g) * h);
+    if (!std::isfinite(s.value)) s.error = std::numeric_limits<double>::infinity();
+}
+
+// Evaluate a batch of segments, slot c takes every slots-th segment
+static void evaluate(const std::function<double(int, double)>& f, int slots,
+    std::vector<Segment>& segs, size_t first)
+{
+    const int count = int(segs.size() - first);
+    const int lanes = std::min(slots, count);
+    ThreadPool::Shared().parallelFor(0, lanes, [&](int c) {
+        for (int j = c; j < count; j += lanes) gk15(f, c, segs[first + j]);
+    });
+}
+
+QuadResult integrateAdaptive(const std::function<double(int, double)>& f, int slots,
+    double a, double b, double absTol, double relTol, int maxIntervals)
+{
+    QuadResult r;
+    if (a == b) return r;
+    slots = std::max(slots, 1);
+
+    // start with one piece per lane so the first round is already parallel
+    const int initial = std::max(1, std::min(slots, maxIntervals));
+    std::vector<Segment> segs(initial);
+    for (int i = 0; i < initial; ++i) {
+        segs[i].a = a + (b - a) * i / initial;
+        segs[i].b = a + (b - a) * (i + 1) / initial;
+    }
+    evaluate(f, slots, segs, 0);
+    r.evals += 15L * initial;
+
+    for (;;) {
+        double value = 0.0, error = 0.0;
+        for (const auto& s : segs) { value += s.value; error += s.error; }
+        r.value = value;
+        r.error = error;
+        const double target = std::max(absTol, relTol * std::fabs(value));
+        if (error <= target || (int)segs.size() >= maxIntervals) break;
+
+        // bisect the worst segments, at most one batch per lane pair
+        std::sort(segs.begin(), segs.end(),
+            [](const Segment& x, const Segment& y) { return x.error > y.error; });
+        const double fair = target / segs.size();
+        int split = 0;
+        const int batch = std::min<int>(2 * slots, maxIntervals - (int)segs.size());
+        while (split < batch && split < (int)segs.size() && segs[split].error > fair) ++split;
+        if (split == 0) split = 1;
+
+        const size_t first = segs.size();
+        for (int i = 0; i < split; ++i) {
+            Segment right;
+            right.a = 0.5 * (segs[i].a + segs[i].b);
+            right.b = segs[i].b;
+            segs[i].b = right.a;
+            segs.push_back(right);
+        }
+        // re-evaluate the shrunk left halves together with the new right halves
+        std::vector<Segment> work(segs.begin(), segs.begin() + split);
+        work.insert(work.end(), segs.begin() + first, segs.end());
+        evaluate(f, slots, work, 0);
+        std::copy(work.begin(), work.begin() + split, segs.begin());
+        std::copy(work.begin() + split, work.end(), segs.begin() + first);
+        r.evals += 15L * (long)work.size();
+
+        if (std::fabs(segs[0].b - segs[0].a) < 1e-12 * std::fabs(b - a)) break;
+    }
+    r.intervals = (int)segs.size();
+    return r;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <functional>
+
+struct QuadResult {
+    double value = 0.0;
+    double error = 0.0;   // estimated absolute error
+    long   evals = 0;     // integrand evaluations
+    int    intervals = 0; // subintervals in the final partition
+};
+
+// Globally adaptive Gauss-Kronrod (7/15) quadrature of f over [a, b].
+// Each refinement round bisects the worst subintervals and evaluates them on
+// the shared thread pool. f(slot, x) is called concurrently with distinct
+// slot values in [0, slots), so every slot can own a private evaluator.
+QuadResult integrateAdaptive(const std::function<double(int, double)>& f, int slots,
+    double a, double b, double absTol = 1e-7, double relTol = 1e-6, int maxIntervals = 4096);
@@ -0,0 +1,59 @@
+#include "Reconstruction.h"
+#include "FFT.h"
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+
+// Transform the signal once and precompute per-harmonic energies
+void PartialReconstruction::setSignal(const std::vector<double>& x) {
+    signal_ = x;
+    const int N = (int)x.size();
+    spectrum_.assign(x.begin(), x.end());
+    if (N > 0) FFT(N).forward(spectrum_);
+
+    const int H = N > 0 ? N / 2 + 1 : 0;
+    weight_.resize(H);
+    totalEnergy_ = 0.0;
+    for (int k = 0; k < H; ++k) {
+        const bool mirrored = k != 0 && !(N % 2 == 0 && k == N / 2);
+        weight_[k] = std::norm(spectrum_[k]) * (mirrored ? 2.0 : 1.0);
+        totalEnergy_ += weight_[k];
+    }
+    order_.resize(H);
+    std::iota(order_.begin(), order_.end(), 0);
+    lastK_ = -1;
+}
+
+// Keep the K heaviest harmonics and synthesize them with one inverse FFT
+const std::vector<double>& PartialReconstruction::reconstruct(int K) {
+    const int N = (int)signal_.size();
+    const int H = (int)order_.size();
+    K = std::clamp(K, 0, H);
+    if (K == lastK_) return out_;
+    lastK_ = K;
+
+    auto heavier = [&](int a, int b) { return weight_[a] > weight_[b]; };
+    if (K > 0 && K < H)
+        std::nth_element(order_.begin(), order_.begin() + (K - 1), order_.end(), heavier);
+
+    work_.assign(N, { 0.0, 0.0 });
+    double kept = 0.0;
+    for (int i = 0; i < K; ++i) {
+        const int k = order_[i];
+        work_[k] = spectrum_[k];
+        if (k != 0) work_[(N - k) % N] = spectrum_[(N - k) % N];
+        kept += weight_[k];
+    }
+    if (N > 0) FFT(N).inverse(work_);
+
+    out_.resize(N);
+    double err = 0.0;
+    for (int n = 0; n < N; ++n) {
+        out_[n] = work_[n].real();
+        const double d = out_[n] - signal_[n];
+        err += d * d;
+    }
+    captured_ = totalEnergy_ > 0.0 ? kept / totalEnergy_ : 1.0;
+    rmsError_ = N > 0 ? std::sqrt(err / N) : 0.0;
+    return out_;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+#include <complex>
+
+// Fourier series reconstruction of a real signal from its K largest bins.
+// The forward transform runs once per signal; changing K only re-selects bins
+// (nth_element over the unique half spectrum) and runs one inverse FFT.
+class PartialReconstruction {
+public:
+    void setSignal(const std::vector<double>& x);
+
+    // Curve rebuilt from the K strongest harmonics (bins 0..N/2, conjugates implied)
+    const std::vector<double>& reconstruct(int K);
+
+    int  harmonics() const { return (int)order_.size(); }
+    // Fraction of signal energy held by the last reconstruction, 0..1
+    double capturedEnergy() const { return captured_; }
+    // RMS difference between the last reconstruction and the signal
+    double rmsError() const { return rmsError_; }
+
+private:
+    std::vector<double> signal_;
+    std::vector<std::complex<double>> spectrum_;
+    std::vector<double> weight_;   // energy of harmonic k incl. its mirror bin
+    std::vector<int> order_;
+    double totalEnergy_ = 0.0;
+
+    int lastK_ = -1;
+    std::vector<std::complex<double>> work_;
+    std::vector<double> out_;
+    double captured_ = 0.0;
+    double rmsError_ = 0.0;
+};
@@ -1,66 +1,924 @@
 ﻿#include "Scene.h"
 #include <cmath>
+#include <cctype>
 #include <sstream>
-#include <exprtk.hpp>
-#include <windows.h>
 #include <complex>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
 #include "Fourier.h"
+#include "FFT.h"
+#include "Filter.h"
+#include "Wavelet.h"
+#include "Welch.h"
+#include "Hilbert.h"
+#include "ThreadPool.h"
+#include "Annotations.h"
+#include "ExprTree.h"
+#include "Dual.h"
+#include "ColumnEval.h"
+#include "CompiledExpr.h"
+#include "LayerBlock.h"
+#include "Workspace.h"
+#include "DrawBatch.h"
+#include <cstdio>
 
 static inline ImU32 RGBA(const ImVec4& c) {
     return IM_COL32(int(c.x * 255), int(c.y * 255), int(c.z * 255), int(c.w * 255));
 }
 
+using Clock = std::chrono::steady_clock;
+
+static const int kMinSamples = 64;
+// auto-N: ceiling of both choices, and curve samples per cycle at the band edge
+static const int kMaxAutoSamples = 16384;
+static const int kCurveSamplesPerCycle = 8;
+
 struct Scene::Impl {
-    using symbol_table_t = exprtk::symbol_table<float>;
-    using expression_t = exprtk::expression<float>;
-    using parser_t = exprtk::parser<float>;
+    using parser_t = CompiledExpr::parser_t;
+
+    Impl() { parser.register_loop_runtime_check(guard); }
 
-    symbol_table_t symbols;
-    expression_t   expression;
+    // current t, a..d: floats bound into every exprtk copy, doubles for the tree
+    float params[kVarCount - 1] = {};
+    double vars[kVarCount] = {};
+    unsigned varsVersion = 0;   // bumped when any of them changes
+
+    // installed program; keeps rendering while a newer source compiles
+    std::shared_ptr<Program> prog = std::make_shared<Program>();
     parser_t       parser;
-    float varX = 0.0f;
-    bool valid = false;
+    std::string    pending;       // normalized source waiting for its compile, empty = none
+    bool hasError = false;        // the latest source failed to compile
     std::string lastError;
+    unsigned exprVersion = 0;   // bumped on every installed program, keys the sample cache
+
+    // column evaluation of the tree on the curve grid, recomputes only what t/a..d touch
+    ColumnEval columns;
+
+    // Chebyshev proxy serving Eval inside [proxyMin, proxyMax] while enabled
+    ChebProxy proxy;
+    bool proxyActive = false;
+    unsigned proxyVersion = ~0u;
+    unsigned proxyVarsVersion = ~0u;
+    float proxyMin = 0.0f, proxyMax = 0.0f;
+
+    // evaluation budget: guard for the current pass, sample limit adapted between passes
+    EvalGuard guard;
+    Clock::time_point passStart;
+    long passEvals = 0;
+    double budgetMs = 30.0;
+    int sampleLimit = 1 << 30;
+    bool lastAborted = false;
+
+    // user convolution kernel k(x) for FILTER_KERNEL
+    CompiledExpr kernel{ params };
+    bool kernelValid = false;
+    std::string kernelSrc;
+    std::string kernelError;
+
+    // compiled programs by normalized source; declared after guard and params it uses
+    ExprCache cache{ params, guard };
+
+    // overlay layers: rows of `block` on the curve grid, one program and column cache each.
+    // Cache requests use owner k + 1, f(x) is owner 0.
+    struct Layer {
+        std::string source;            // text last taken from the config
+        std::string pending;           // normalized source waiting for its compile
+        std::shared_ptr<Program> prog;
+        ColumnEval columns;
+        bool hasError = false;
+        std::string error;
+        bool varying = true;           // depends on t or a..d
+        unsigned varsVersion = ~0u;    // variables its row was sampled with
+    };
+    std::vector<Layer> layers;
+    LayerBlock block;
+
+    // sampled curve cache
+    std::vector<double> curveY;
+    unsigned curveVersion = ~0u;
+    unsigned curveVarsVersion = ~0u;
+    int   curveN = 0;
+    float curveMin = 0.0f, curveMax = 0.0f;
+    unsigned curveGeneration = 0;   // bumped whenever curveY is resampled
+    bool curveExact = false;        // f itself, not the Chebyshev proxy
+
+    // transform-view spectrum, redone when f, its variables, N or the window change
+    FourierSpectrum spectrum;
+    unsigned spectrumVersion = ~0u;
+    unsigned spectrumVarsVersion = ~0u;
+    int   spectrumN = 0;
+    float spectrumCenter = 0.0f, spectrumRange = 0.0f;
+    std::vector<double> spectrumWindow;   // the samples behind spectrum, empty when it came from the seed
+    unsigned spectrumGeneration = 0;      // bumped whenever spectrum is redone
+
+    // filter overlay of the transform view, redone when spectrum or the filter spec change
+    FourierSpectrum filteredSpectrum;
+    unsigned filteredGeneration = ~0u;
+    FilterSpec filteredSpec;
+
+    // workspace snapshot entries not matched yet; each is taken once, when its inputs come up again
+    WorkspaceCache seed;
+
+    // top-K Fourier series overlay of the sampled curve
+    PartialReconstruction recon;
+    unsigned reconGeneration = ~0u;
+
+    // continuous wavelet transform of the sampled curve
+    Scalogram scalogram;
+    // Welch PSD of the sampled curve, segment periodograms kept per offset
+    WelchPSD psd;
+    // analytic signal of the sampled curve (envelope, phase, frequency)
+    AnalyticSignal analytic;
+
+    // auto-N: coarse spectra of f over the plotted range and the transform window
+    BandwidthProbe curveProbe, spectrumProbe;
+    AutoSamples autoN;
+
+    // per-layer geometry built on the thread pool, merged in drawing order
+    DrawBatch batch;
 
-    Impl() {
-        symbols.add_variable("x", varX);
-        symbols.add_constants();
-        expression.register_symbol_table(symbols);
+    // definite integral over [quadA, quadB], updated by deltas while the bounds move
+    QuadResult quad;
+    unsigned quadVersion = ~0u;
+    unsigned quadVarsVersion = ~0u;
+    float quadA = 0.0f, quadB = 0.0f;
+
+    // derivatives on the curve grid and the curvature-refined polyline (world space)
+    std::vector<double> derivY1, derivY2;
+    unsigned derivGeneration = ~0u;
+    std::vector<ImVec2> refined;
+    unsigned refinedGeneration = ~0u;
+    float refinedUnit = 0.0f;
+
+    // interval trace of f(x), redone when the view or the expression changes
+    std::vector<ImVec2> traced;
+    TraceStats traceStats;
+    unsigned tracedGeneration = ~0u;
+    ImVec2 tracedCenter, tracedSize;
+    float tracedUnit = 0.0f;
+
+    // annotation markers found on the sampled curve
+    std::vector<Feature> features;
+    unsigned featuresGeneration = ~0u;
+
+    // filtering stage, one filter per sample grid so both kernel spectra stay cached
+    SignalFilter curveFilter, spectrumFilter;
+    std::vector<double> curveFiltered, spectrumFiltered;
+
+    // One evaluation under the pass guard, NaN once the pass is over budget
+    float Guarded(CompiledExpr& e, float x) {
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        if (guard.tripped) return nan;
+        if ((++passEvals & 31) == 0 && guard.Expired()) {
+            guard.tripped = true;
+            return nan;
+        }
+        const float v = e.Eval(x);
+        return guard.tripped ? nan : v;
+    }
+
+    // depends on t or a..d
+    static bool Varying(const Program& p) {
+        return !p.treeValid || (p.tree.mask(p.tree.root()) & ~1u) != 0;
     }
+
+    bool SameParams(const float* p) const {
+        return std::equal(p, p + kVarCount - 1, params);
+    }
+
+    // move the seed's values out when they were sampled from p on this grid with these variables
+    bool TakeSeed(CachedSamples& s, const Program& p, double xMin, double xMax, int n, std::vector<double>& out) {
+        if (s.source.empty() || s.source != p.key || s.n != n || s.xMin != xMin || s.xMax != xMax ||
+            (Varying(p) && !SameParams(s.params)))
+            return false;
+        out = std::move(s.values);
+        s = CachedSamples();
+        return true;
+    }
+
+    void CompileKernel(const std::string& src) {
+        kernelSrc = src;
+        kernelValid = parser.compile(src, kernel.expression);
+        kernelError.clear();
+        if (!kernelValid && parser.error_count() > 0)
+            kernelError = "Kernel error: " + parser.get_error(0).diagnostic;
+    }
+
 };
 
 Scene::Scene() : impl(std::make_unique<Impl>()) {}
 Scene::~Scene() = default;   // now compiler sees full Impl type
 
 void Scene::SetExpression(const std::string& expr) {
-    impl->valid = impl->parser.compile(expr, impl->expression);
-    if (!impl->valid) {
-        std::ostringstream oss;
-        oss << "Parse error in expression: " << expr << "\n";
-        for (std::size_t i = 0; i < impl->parser.error_count(); ++i) {
-            auto e = impl->parser.get_error(i);
-            oss << "Error " << i
-                << " at pos " << e.token.position
-                << " [" << exprtk::parser_error::to_str(e.mode)
-                << "] " << e.diagnostic << "\n";
+    const std::string key = ExprCache::Normalize(expr);
+    if (impl->prog->valid && key == impl->prog->key) {
+        impl->pending.clear();
+        impl->hasError = false;
+        return;
+    }
+    if (key == impl->pending) return;
+    impl->pending = key;
+    if (auto p = impl->cache.Request(expr)) Install(p);
+}
+
+void Scene::Install(const std::shared_ptr<Program>& p) {
+    impl->pending.clear();
+    if (!p->valid) {
+        // keep drawing the previous expression, only report the error
+        impl->hasError = true;
+        impl->lastError = p->error;
+        return;
+    }
+    impl->hasError = false;
+    impl->prog = p;
+    ++impl->exprVersion;
+    // compiled against its own t, a..d; from here on they follow the sliders
+    p->SetVars(impl->params);
+    p->VerifyTree(impl->vars);
+    impl->columns.bind(p->treeValid ? &p->tree : nullptr, 0, kVarCount);
+    for (int i = 1; i < kVarCount; ++i) impl->columns.setVar(i, impl->vars[i]);
+
+    // first guess for N: half the budget spent on the curve pass
+    const ExprProfile& pr = p->profile;
+    const double fit = 0.5 * impl->budgetMs * 1000.0 / std::max(pr.evalUs, 1e-3);
+    impl->sampleLimit = pr.aborted ? kMinSamples : (int)std::clamp(fit, (double)kMinSamples, double(1 << 30));
+    // a snapshot pass of this program is free to draw at its N
+    if (impl->seed.curve.source == p->key) impl->sampleLimit = std::max(impl->sampleLimit, impl->seed.curve.n);
+}
+
+void Scene::PollCompiled() {
+    for (const auto& p : impl->cache.Poll()) {
+        if (p->key == impl->pending) Install(p);
+        for (int k = 0; k < (int)impl->layers.size(); ++k)
+            if (p->key == impl->layers[k].pending) InstallLayer(k, p);
+    }
+}
+
+void Scene::InstallLayer(int k, const std::shared_ptr<Program>& p) {
+    Impl::Layer& layer = impl->layers[k];
+    layer.pending.clear();
+    if (!p->valid) {
+        layer.hasError = true;
+        layer.error = p->error;
+        return;
+    }
+    layer.hasError = false;
+    layer.prog = p;
+    p->SetVars(impl->params);
+    p->VerifyTree(impl->vars);
+    layer.columns.bind(p->treeValid ? &p->tree : nullptr, 0, kVarCount);
+    for (int i = 1; i < kVarCount; ++i) layer.columns.setVar(i, impl->vars[i]);
+    layer.varying = !p->treeValid || (p->tree.mask(p->tree.root()) & ~1u) != 0;
+    impl->block.invalidate(k);
+}
+
+void Scene::SyncLayers(const AppConfig& cfg) {
+    const int count = (int)cfg.layers.size();
+    impl->layers.resize(count);
+    impl->block.setLayers(count);
+    for (int k = 0; k < count; ++k) {
+        Impl::Layer& layer = impl->layers[k];
+        if (layer.source == cfg.layers[k].expr) continue;
+        layer.source = cfg.layers[k].expr;
+        const std::string key = ExprCache::Normalize(layer.source);
+        layer.hasError = false;
+        if (key.empty()) {
+            layer.pending.clear();
+            layer.prog.reset();
+            continue;
+        }
+        if (layer.prog && key == layer.prog->key) { layer.pending.clear(); continue; }
+        layer.pending = key;
+        if (auto p = impl->cache.Request(layer.source, k + 1)) InstallLayer(k, p);
+    }
+}
+
+void Scene::RemoveLayer(int k) {
+    if (k < 0 || k >= (int)impl->layers.size()) return;
+    impl->layers.erase(impl->layers.begin() + k);
+    impl->block.erase(k);
+}
+
+// Dirty rows only: a layer is resampled when the grid, its program or a variable it reads changes
+void Scene::SampleLayers(const AppConfig& cfg) {
+    LayerBlock& block = impl->block;
+    const int N = block.samples();
+    for (int k = 0; k < block.layers(); ++k) {
+        Impl::Layer& layer = impl->layers[k];
+        if (!layer.prog || !cfg.layers[k].visible) continue;
+        if (layer.varying && layer.varsVersion != impl->varsVersion) block.invalidate(k);
+        if (!block.dirty(k)) continue;
+
+        std::vector<double> restored;
+        double* row = block.write(k);
+        if (k < (int)impl->seed.layers.size() &&
+            impl->TakeSeed(impl->seed.layers[k], *layer.prog, block.x(0), block.x(N - 1), N, restored)) {
+            std::copy(restored.begin(), restored.end(), row);
+        }
+        else if (layer.prog->treeValid) {
+            layer.columns.setGrid(block.x(0), block.x(N - 1), N);
+            const std::vector<double>& ys = layer.columns.evaluate();
+            std::copy(ys.begin(), ys.end(), row);
+        }
+        else {
+            for (int i = 0; i < N; ++i) row[i] = impl->Guarded(*layer.prog->main, (float)block.x(i));
         }
-        impl->lastError = oss.str();
-        //MessageBoxA(nullptr, oss.str().c_str(), "Expression Error", MB_OK | MB_ICONERROR);
+        layer.varsVersion = impl->varsVersion;
+        // a row cut short by the budget is redone next pass
+        if (impl->guard.tripped) block.invalidate(k);
     }
 }
 
+void Scene::UpdateAutoSamples(const AppConfig& cfg, float xMin, float xMax, float unit) {
+    AutoSamples& a = impl->autoN;
+    a.active = false;
+    if (!cfg.autoSamples || !impl->prog->valid) return;
+
+    // variables f does not read leave the estimate valid
+    const unsigned vars = Impl::Varying(*impl->prog) ? impl->varsVersion : 0u;
+    const unsigned long long id = (unsigned long long)impl->exprVersion << 32 | vars;
+    const double tol = std::max((double)cfg.aliasTolerance, 1e-6);
+    std::function<double(double)> f = [&](double x) -> double { return Eval((float)x); };
+    // a grid level cut short by the budget is dropped; the probe refines from
+    // the last complete one on a later pass
+    std::function<bool()> interrupted = [&] { return (bool)impl->guard.tripped; };
+    // both probes together stay under one pass worth of evaluations (the two
+    // grids of a probe take 1.75 points per point of the main grid)
+    const int maxPoints = std::clamp(impl->sampleLimit / 4, kMinSamples, kMaxAutoSamples);
+    BandwidthProbe& c = impl->curveProbe;
+    BandwidthProbe& s = impl->spectrumProbe;
+    c.estimate(f, id, xMin, xMax, tol, maxPoints, interrupted);
+    s.estimate(f, id, cfg.fourierCenter - cfg.fourierRange, cfg.fourierCenter + cfg.fourierRange, tol,
+        maxPoints, interrupted);
+    if (!c.valid() || !s.valid()) return;
+
+    // the curve only needs to follow f as far as the screen can show it
+    const int pixels = std::clamp(int((xMax - xMin) * unit), kMinSamples, kMaxAutoSamples);
+    a.curveN = std::clamp(kCurveSamplesPerCycle * c.bandwidthBins() + 1, kMinSamples, pixels);
+    a.spectrumN = s.spectrumSize(tol, kMinSamples, kMaxAutoSamples);
+    a.curveAlias = c.aliasError(a.curveN);
+    a.spectrumAlias = s.aliasError(a.spectrumN);
+    a.curveBandwidth = c.bandwidth();
+    a.spectrumBandwidth = s.bandwidth();
+    a.resolved = c.resolved() && s.resolved();
+    a.active = true;
+}
+
+int Scene::RequestedSamples(const AppConfig& cfg, bool spectrum) const {
+    if (cfg.autoSamples && impl->autoN.active)
+        return spectrum ? impl->autoN.spectrumN : impl->autoN.curveN;
+    return (cfg.samples > 2 ? cfg.samples : 2);
+}
+
+int Scene::EffectiveSamples(const AppConfig& cfg, bool spectrum) const {
+    const int N = RequestedSamples(cfg, spectrum);
+    return std::max(2, std::min(N, impl->sampleLimit));
+}
+
+void Scene::BeginPass(const AppConfig& cfg) {
+    impl->budgetMs = cfg.evalBudgetMs;
+    impl->guard.Arm(cfg.evalBudgetMs);
+    impl->passStart = Clock::now();
+    impl->passEvals = 0;
+}
+
+// Halve N after an aborted pass; double it again once a pass would still fit at 2N
+void Scene::EndPass(const AppConfig& cfg, bool spectrum) {
+    const double ms = std::chrono::duration<double, std::milli>(Clock::now() - impl->passStart).count();
+    impl->guard.Disarm();
+    impl->lastAborted = impl->guard.tripped;
+
+    const int requested = RequestedSamples(cfg, spectrum);
+    const int current = EffectiveSamples(cfg, spectrum);
+    if (impl->guard.tripped)
+        impl->sampleLimit = std::max(kMinSamples, current / 2);
+    else if (impl->passEvals > 0 && current < requested && 2.0 * ms < 0.5 * cfg.evalBudgetMs)
+        impl->sampleLimit = std::min(requested, current * 2);
+}
+
+void Scene::SyncVariables(const AppConfig& cfg) {
+    const float values[kVarCount - 1] = { cfg.time, cfg.params[0], cfg.params[1], cfg.params[2], cfg.params[3] };
+    bool changed = false;
+    for (int i = 1; i < kVarCount; ++i) {
+        if (impl->params[i - 1] == values[i - 1]) continue;
+        impl->params[i - 1] = values[i - 1];
+        impl->vars[i] = values[i - 1];
+        impl->columns.setVar(i, values[i - 1]);
+        for (auto& layer : impl->layers) layer.columns.setVar(i, values[i - 1]);
+        changed = true;
+    }
+    if (!changed) return;
+    ++impl->varsVersion;
+    // installed programs read their own copy, written only here and in Install
+    impl->prog->SetVars(impl->params);
+    for (auto& layer : impl->layers)
+        if (layer.prog) layer.prog->SetVars(impl->params);
+}
+
 float Scene::Eval(float x) {
-    if (!impl->valid) return 0.0f;
-    impl->varX = x;
-    return impl->expression.value();
+    if (!impl->prog->valid) return 0.0f;
+    double y;
+    if (impl->proxyActive && impl->proxy.evaluate(x, y)) return (float)y;
+
+    // once the pass is over budget the remaining samples are skipped
+    return impl->Guarded(*impl->prog->main, x);
+}
+
+void Scene::UpdateProxy(const AppConfig& cfg, float xMin, float xMax) {
+    if (!cfg.chebProxy || !impl->prog->valid) {
+        if (impl->proxyActive) {
+            impl->proxy.clear();
+            impl->proxyActive = false;
+            impl->proxyVersion = ~0u;
+            impl->curveVersion = ~0u;   // the cached curve came from the proxy
+        }
+        return;
+    }
+    if (impl->proxyActive && impl->proxyVersion == impl->exprVersion &&
+        impl->proxyVarsVersion == impl->varsVersion &&
+        impl->proxyMin == xMin && impl->proxyMax == xMax)
+        return;
+
+    const int slots = (int)ThreadPool::Shared().concurrency();
+    impl->prog->PrepareWorkers(slots);
+    std::function<double(int, double)> f = [&](int slot, double x) -> double {
+        return impl->prog->workers[slot]->Eval((float)x);
+    };
+    // exprtk runs in float, so "machine precision" is a few float ulps
+    impl->proxy.fit(f, slots, xMin, xMax, 1e-6);
+    if (impl->guard.tripped) {
+        // an interrupted fit would serve truncated loop results, retry next pass
+        impl->proxy.clear();
+        impl->proxyActive = false;
+        impl->proxyVersion = ~0u;
+        return;
+    }
+
+    impl->proxyActive = true;
+    impl->proxyVersion = impl->exprVersion;
+    impl->proxyVarsVersion = impl->varsVersion;
+    impl->proxyMin = xMin;
+    impl->proxyMax = xMax;
+    impl->curveVersion = ~0u;   // resample the curve through the proxy
+}
+
+const std::vector<double>& Scene::SampleCurve(float xMin, float xMax, int N) {
+    if (impl->curveVersion != impl->exprVersion || impl->curveVarsVersion != impl->varsVersion ||
+        impl->curveN != N || impl->curveMin != xMin || impl->curveMax != xMax)
+    {
+        if (impl->TakeSeed(impl->seed.curve, *impl->prog, xMin, xMax, N, impl->curveY)) {
+            // the workspace snapshot had exactly this pass
+            impl->curveExact = true;
+        }
+        else if (impl->prog->treeValid && !impl->proxyActive) {
+            // only the subtrees that depend on a changed variable are recomputed
+            impl->columns.setGrid(xMin, xMax, N);
+            impl->curveY = impl->columns.evaluate();
+            impl->curveExact = true;
+        }
+        else {
+            impl->curveY.resize(N);
+            for (int i = 0; i < N; ++i) {
+                float t = float(i) / float(N - 1);
+                impl->curveY[i] = Eval(xMin + t * (xMax - xMin));
+            }
+            impl->curveExact = !impl->proxyActive;
+        }
+        // a pass cut short by the budget is not cached
+        impl->curveVersion = impl->guard.tripped ? ~0u : impl->exprVersion;
+        impl->curveVarsVersion = impl->varsVersion;
+        impl->curveN = N;
+        impl->curveMin = xMin;
+        impl->curveMax = xMax;
+        ++impl->curveGeneration;
+    }
+    return impl->curveY;
+}
+
+const std::vector<double>& Scene::FilterSignal(const std::vector<double>& signal, double dx,
+    const AppConfig& cfg, bool spectrum)
+{
+    if (cfg.filterType == FILTER_KERNEL && impl->kernelSrc != cfg.filterKernel)
+        impl->CompileKernel(cfg.filterKernel);
+
+    FilterSpec spec;
+    spec.type = cfg.filterType;
+    spec.low = cfg.filterLow;
+    spec.high = cfg.filterHigh;
+    spec.width = cfg.filterWidth;
+    if (cfg.filterType == FILTER_KERNEL) spec.kernelExpr = impl->kernelSrc;
+
+    auto kernel = [&](double t) -> double {
+        return impl->kernelValid ? impl->kernel.Eval((float)t) : 0.0;
+    };
+
+    auto& filter = spectrum ? impl->spectrumFilter : impl->curveFilter;
+    auto& out = spectrum ? impl->spectrumFiltered : impl->curveFiltered;
+    filter.apply(signal, dx, spec, kernel, out);
+    return out;
+}
+
+void Scene::UpdateIntegral(const AppConfig& cfg) {
+    const float a = cfg.quadA, b = cfg.quadB;
+    if (!impl->prog->valid) {
+        impl->quad = QuadResult();
+        impl->quadVersion = ~0u;
+        return;
+    }
+
+    const int slots = (int)ThreadPool::Shared().concurrency();
+    impl->prog->PrepareWorkers(slots);
+    auto f = [&](int slot, double x) -> double { return impl->prog->workers[slot]->Eval((float)x); };
+
+    QuadResult& q = impl->quad;
+    const bool sameExpr = impl->quadVersion == impl->exprVersion &&
+        impl->quadVarsVersion == impl->varsVersion;
+    if (sameExpr && a == impl->quadA && b == impl->quadB) return;
+
+    // while the bounds are dragged only the strips they moved across are integrated;
+    // a full pass resets the accumulated error once it stops being negligible
+    const bool drifted = q.error > 1e-4 * std::max(1.0, std::fabs(q.value));
+    if (sameExpr && !drifted) {
+        QuadResult hi = integrateAdaptive(f, slots, impl->quadB, b);
+        QuadResult lo = integrateAdaptive(f, slots, impl->quadA, a);
+        q.value += hi.value - lo.value;
+        q.error += hi.error + lo.error;
+        q.evals = hi.evals + lo.evals;
+    }
+    else {
+        q = integrateAdaptive(f, slots, a, b);
+    }
+    impl->quadVersion = impl->guard.tripped ? ~0u : impl->exprVersion;
+    impl->quadVarsVersion = impl->varsVersion;
+    impl->quadA = a;
+    impl->quadB = b;
+}
+
+// Area between f and the x axis over [quadA, quadB], filled as one triangle strip
+// built from the already sampled curve plus interpolated ends and zero crossings.
+void Scene::DrawIntegral(const ImVec2& center, float unit, const AppConfig& cfg,
+    float xMin, float xMax, const std::vector<double>& ys, ImDrawList* dl, const ImVec2& uv) const
+{
+    const int N = (int)ys.size();
+    const float lo = std::max(std::min(cfg.quadA, cfg.quadB), xMin);
+    const float hi = std::min(std::max(cfg.quadA, cfg.quadB), xMax);
+    if (N < 2 || hi <= lo) return;
+
+    const double dx = double(xMax - xMin) / (N - 1);
+    auto sampleAt = [&](double x) {
+        double u = (x - xMin) / dx;
+        int i = std::clamp(int(u), 0, N - 2);
+        double t = u - i;
+        return ys[i] + (ys[i + 1] - ys[i]) * t;
+    };
+
+    std::vector<ImVec2> edge;   // world-space top edge, left to right
+    auto push = [&](double x, double y) {
+        if (!edge.empty() && (edge.back().y > 0) != (y > 0) && std::isfinite(y)) {
+            const double x0 = edge.back().x, y0 = edge.back().y;
+            if (y0 != 0.0 && y != 0.0) edge.emplace_back((float)(x0 - y0 * (x - x0) / (y - y0)), 0.0f);
+        }
+        edge.emplace_back((float)x, std::isfinite(y) ? (float)y : 0.0f);
+    };
+    push(lo, sampleAt(lo));
+    for (int i = int(std::ceil((lo - xMin) / dx)); i < N; ++i) {
+        const double x = xMin + i * dx;
+        if (x <= lo) continue;
+        if (x >= hi) break;
+        push(x, ys[i]);
+    }
+    push(hi, sampleAt(hi));
+
+    auto toScreen = [&](float x, float y) {
+        return ImVec2(center.x + x * unit, std::clamp(center.y - y * unit, -1e5f, 1e5f));
+    };
+
+    const ImU32 fill = RGBA(cfg.quadColor);
+    const int kMaxSegments = 8192;   // keeps each reservation inside 16-bit indices
+    for (size_t s = 0; s + 1 < edge.size(); s += kMaxSegments) {
+        const int segs = (int)std::min<size_t>(kMaxSegments, edge.size() - 1 - s);
+        dl->PrimReserve(segs * 6, (segs + 1) * 2);
+        const ImDrawIdx base = (ImDrawIdx)dl->_VtxCurrentIdx;
+        for (int i = 0; i <= segs; ++i) {
+            const ImVec2& p = edge[s + i];
+            dl->PrimWriteVtx(toScreen(p.x, 0.0f), uv, fill);
+            dl->PrimWriteVtx(toScreen(p.x, p.y), uv, fill);
+        }
+        for (int i = 0; i < segs; ++i) {
+            const ImDrawIdx b0 = ImDrawIdx(base + 2 * i), t0 = ImDrawIdx(b0 + 1);
+            const ImDrawIdx b1 = ImDrawIdx(b0 + 2), t1 = ImDrawIdx(b0 + 3);
+            dl->PrimWriteIdx(b0); dl->PrimWriteIdx(t0); dl->PrimWriteIdx(t1);
+            dl->PrimWriteIdx(b0); dl->PrimWriteIdx(t1); dl->PrimWriteIdx(b1);
+        }
+    }
+
+    const ImU32 border = RGBA(cfg.quadBorderColor);
+    std::vector<ImVec2> outline;
+    outline.reserve(edge.size() + 2);
+    outline.push_back(toScreen(edge.front().x, 0.0f));
+    for (const auto& p : edge) outline.push_back(toScreen(p.x, p.y));
+    outline.push_back(toScreen(edge.back().x, 0.0f));
+    dl->AddPolyline(outline.data(), (int)outline.size(), border, 0, 1.5f);
+}
+
+void Scene::UpdateDerivatives(float xMin, float xMax, const std::vector<double>& ys) {
+    if (impl->derivGeneration == impl->curveGeneration) return;
+    impl->derivGeneration = impl->curveGeneration;
+
+    const int N = (int)ys.size();
+    const double dx = double(xMax - xMin) / (N - 1);
+    auto& d1 = impl->derivY1;
+    auto& d2 = impl->derivY2;
+    d1.assign(N, 0.0);
+    d2.assign(N, 0.0);
+
+    if (impl->prog->treeValid) {
+        // forward-mode AD: one Dual2 pass gives f' and f'' at every sample
+        const ExprTree& tree = impl->prog->tree;
+        const int chunks = (int)ThreadPool::Shared().concurrency();
+        ThreadPool::Shared().parallelFor(0, chunks, [&](int c) {
+            Dual2 v[kVarCount];
+            for (int k = 1; k < kVarCount; ++k) v[k] = Dual2(impl->vars[k]);
+            for (int i = c * N / chunks; i < (c + 1) * N / chunks; ++i) {
+                v[0] = Dual2::Variable(xMin + i * dx);
+                Dual2 r = tree.eval(v);
+                d1[i] = r.d;
+                d2[i] = r.dd;
+            }
+        });
+        return;
+    }
+
+    // outside the tree subset: differences of the existing samples, no extra evaluations
+    for (int i = 0; i < N; ++i) {
+        const int l = std::max(i - 1, 0), r = std::min(i + 1, N - 1);
+        d1[i] = (ys[r] - ys[l]) / ((r - l) * dx);
+    }
+    for (int i = 1; i < N - 1; ++i) d2[i] = (ys[i + 1] - 2.0 * ys[i] + ys[i - 1]) / (dx * dx);
+    if (N > 2) { d2[0] = d2[1]; d2[N - 1] = d2[N - 2]; }
+}
+
+// Chord error of a segment of length h is about h^2/8 * |f''|; segments whose
+// error exceeds a quarter pixel get sqrt-proportional extra points.
+const std::vector<ImVec2>& Scene::RefineCurve(float xMin, float xMax, float unit, const std::vector<double>& ys) {
+    if (impl->refinedGeneration == impl->curveGeneration && impl->refinedUnit == unit)
+        return impl->refined;
+    UpdateDerivatives(xMin, xMax, ys);
+
+    const int N = (int)ys.size();
+    const double dx = double(xMax - xMin) / (N - 1);
+    const double kTolPx = 0.25;
+    const int kMaxSplit = 64;
+    double v[kVarCount];
+    std::copy(impl->vars, impl->vars + kVarCount, v);
+    auto& out = impl->refined;
+    out.clear();
+    out.reserve(N);
+    for (int i = 0; i < N; ++i) {
+        const double x0 = xMin + i * dx;
+        out.emplace_back((float)x0, (float)ys[i]);
+        if (i == N - 1 || !std::isfinite(ys[i]) || !std::isfinite(ys[i + 1])) continue;
+
+        const double curv = std::max(std::fabs(impl->derivY2[i]), std::fabs(impl->derivY2[i + 1]));
+        const double errPx = dx * dx / 8.0 * curv * unit;
+        if (!(errPx > kTolPx)) continue;
+        const int m = std::min(kMaxSplit, (int)std::ceil(std::sqrt(errPx / kTolPx)));
+        for (int k = 1; k < m; ++k) {
+            v[0] = x0 + dx * k / m;
+            const double y = impl->prog->treeValid ? impl->prog->tree.eval(v) : (double)Eval((float)v[0]);
+            out.emplace_back((float)v[0], (float)y);
+        }
+    }
+    impl->refinedGeneration = impl->curveGeneration;
+    impl->refinedUnit = unit;
+    return out;
+}
+
+const std::vector<ImVec2>& Scene::TraceCurve(const ImVec2& center, const ImVec2& windowSize,
+    float unit, float xMin, float xMax, int N)
+{
+    if (impl->tracedGeneration == impl->curveGeneration && impl->tracedUnit == unit &&
+        impl->tracedCenter.y == center.y && impl->tracedSize.y == windowSize.y &&
+        impl->tracedCenter.x == center.x)
+        return impl->traced;
+
+    // world y range covered by the window, one pixel of slack for the line width
+    const double yMax = (center.y + 1.0) / unit;
+    const double yMin = (center.y - windowSize.y - 1.0) / unit;
+    const std::vector<TracePoint> pts = traceCurve(impl->prog->tree, impl->vars, xMin, xMax, yMin, yMax,
+        unit, N, &impl->traceStats);
+
+    auto& out = impl->traced;
+    out.resize(pts.size());
+    for (size_t i = 0; i < pts.size(); ++i)
+        out[i] = ImVec2(center.x + (float)pts[i].x * unit, center.y - (float)pts[i].y * unit);
+
+    impl->tracedGeneration = impl->curveGeneration;
+    impl->tracedUnit = unit;
+    impl->tracedCenter = center;
+    impl->tracedSize = windowSize;
+    return out;
+}
+
+void Scene::UpdateAnnotations(float xMin, float xMax, const std::vector<double>& ys) {
+    const int N = (int)ys.size();
+    if (N < 3 || !impl->prog->valid) {
+        impl->features.clear();
+        impl->featuresGeneration = ~0u;
+        return;
+    }
+    if (impl->featuresGeneration == impl->curveGeneration) return;
+
+    const double dx = double(xMax - xMin) / (N - 1);
+    const int slots = (int)ThreadPool::Shared().concurrency();
+    impl->prog->PrepareWorkers(slots);
+    impl->features = refineBrackets(scanBrackets(ys, xMin, dx),
+        [&](int slot, double x) -> double { return impl->prog->workers[slot]->Eval((float)x); }, slots);
+    impl->featuresGeneration = impl->curveGeneration;
+}
+
+void Scene::DrawAnnotations(const ImVec2& center, const ImVec2& windowSize, float unit,
+    const AppConfig& cfg, ImDrawList* dl) const
+{
+    const ImU32 col = RGBA(cfg.annotationColor);
+    const int kMaxLabels = 64;
+    int labels = 0;
+    for (const Feature& ft : impl->features) {
+        const float sx = center.x + (float)ft.x * unit;
+        const float sy = center.y - (float)ft.y * unit;
+        bool labelled = false;
+        switch (ft.kind) {
+        case FEATURE_ROOT:
+            if (!cfg.showRoots) continue;
+            dl->AddCircle(ImVec2(sx, sy), 5.0f, col, 12, 2.0f);
+            labelled = true;
+            break;
+        case FEATURE_MAXIMUM:
+        case FEATURE_MINIMUM: {
+            if (!cfg.showExtrema) continue;
+            const float d = ft.kind == FEATURE_MAXIMUM ? -1.0f : 1.0f;
+            dl->AddTriangleFilled(ImVec2(sx, sy), ImVec2(sx - 5.0f, sy + d * 9.0f), ImVec2(sx + 5.0f, sy + d * 9.0f), col);
+            labelled = true;
+            break;
+        }
+        case FEATURE_POLE:
+            if (!cfg.showAsymptotes) continue;
+            for (float y = 0.0f; y < windowSize.y; y += 12.0f)
+                dl->AddLine(ImVec2(sx, y), ImVec2(sx, y + 6.0f), col, 1.5f);
+            break;
+        }
+        if (labelled && labels < kMaxLabels) {
+            char label[64];
+            std::snprintf(label, sizeof(label), "(%.4g, %.4g)", ft.x, ft.y);
+            dl->AddText(ImVec2(sx + 6.0f, sy + 4.0f), col, label);
+            ++labels;
+        }
+    }
+}
+
+// Filtered spectrum drawn over Fourier::renderTransform, same plot area and amplitude scale
+static void DrawSpectrumOverlay(const FourierSpectrum& spec, double ampMax,
+    const ImVec2& p0, const ImVec2& p1, ImDrawList* draw, ImU32 color)
+{
+    const float left = p0.x + 50.0f;
+    const float right = p1.x - 10.0f;
+    const float top = p0.y + 10.0f;
+    const float bottom = p1.y - 25.0f;
+    if (ampMax <= 1e-12) ampMax = 1.0;
+
+    const size_t N = std::min(spec.freqs.size(), spec.magn.size());
+    auto toPlot = [&](size_t i) {
+        float t = (float)((spec.freqs[i] + spec.wMax) / (2.0 * spec.wMax));
+        float a = (float)std::min(spec.magn[i] / ampMax, 1.0);
+        return ImVec2(left + t * (right - left), bottom - a * (bottom - top));
+    };
+    for (size_t i = 1; i < N; ++i)
+        draw->AddLine(toPlot(i - 1), toPlot(i), color, 1.5f);
+}
+
+// Heat colour for t in [0, 1]: dark blue -> cyan -> yellow -> red
+static ImU32 HeatColor(float t) {
+    static const float stops[5][3] = {
+        { 10, 10, 40 }, { 20, 90, 200 }, { 40, 220, 220 }, { 250, 230, 40 }, { 230, 40, 20 } };
+    t = std::clamp(t, 0.0f, 1.0f) * 4.0f;
+    const int i = std::min(int(t), 3);
+    const float f = t - i;
+    auto ch = [&](int c) { return int(stops[i][c] + (stops[i + 1][c] - stops[i][c]) * f); };
+    return IM_COL32(ch(0), ch(1), ch(2), 255);
+}
+
+// Scalogram heatmap, time along x and frequency (high at the top) along y.
+// Samples are max-pooled into at most one cell per two pixels; rows are
+// split across the batch.
+static void DrawScalogram(const Scalogram& sc, const ImVec2& p0, const ImVec2& p1, DrawBatch& batch) {
+    batch.add([p0, p1](ImDrawList* draw) { draw->AddRectFilled(p0, p1, IM_COL32(25, 25, 25, 255)); });
+
+    const float left = p0.x + 50.0f;
+    const float right = p1.x - 10.0f;
+    const float top = p0.y + 10.0f;
+    const float bottom = p1.y - 10.0f;
+    const int S = sc.scales();
+    const int N = sc.length();
+    if (S == 0 || N == 0 || right <= left) return;
+
+    const int cols = std::max(1, std::min(N, int((right - left) / 2.0f)));
+    const float cellW = (right - left) / cols;
+    const float cellH = (bottom - top) / S;
+    const float scale = sc.maxValue() > 0.0f ? 1.0f / sc.maxValue() : 1.0f;
+
+    batch.addRange(S, [&sc, N, cols, left, top, cellW, cellH, scale](ImDrawList* draw, int s0, int s1) {
+        for (int s = s0; s < s1; ++s) {
+            const float* row = sc.row(s);
+            const float y0 = top + s * cellH;
+            for (int c = 0; c < cols; ++c) {
+                const int n0 = int((long long)c * N / cols);
+                const int n1 = std::max(n0 + 1, int((long long)(c + 1) * N / cols));
+                float v = 0.0f;
+                for (int n = n0; n < n1; ++n) v = std::max(v, row[n]);
+                const float x0 = left + c * cellW;
+                draw->AddRectFilled(ImVec2(x0, y0), ImVec2(x0 + cellW + 0.5f, y0 + cellH + 0.5f),
+                    HeatColor(std::sqrt(v * scale)));
+            }
+        }
+    }, std::max(1, 4096 / cols));
+
+    batch.add([&sc, S, p0, left, right, top, bottom, cellH](ImDrawList* draw) {
+        const ImU32 textCol = IM_COL32(200, 200, 200, 255);
+        for (int s = 0; s < S; s += std::max(1, S / 4)) {
+            char label[32];
+            std::snprintf(label, sizeof(label), "%.2f", sc.frequency(s));
+            draw->AddText(ImVec2(p0.x + 5.0f, top + s * cellH), textCol, label);
+        }
+        draw->AddRect(ImVec2(left, top), ImVec2(right, bottom), IM_COL32(90, 90, 90, 255));
+    });
+}
+
+// Welch PSD in dB with its 95% band shaded, 80 dB below the peak; same plot
+// area as Fourier::renderTransform
+static void DrawPSD(const WelchPSD& psd, const ImVec2& p0, const ImVec2& p1, ImU32 color, DrawBatch& batch) {
+    const float left = p0.x + 50.0f;
+    const float right = p1.x - 10.0f;
+    const float top = p0.y + 10.0f;
+    const float bottom = p1.y - 25.0f;
+    const int K = psd.bins();
+    const double wMax = K > 1 ? psd.frequency(K - 1) : 1.0;
+    const double peakDb = 10.0 * std::log10(std::max(psd.maxValue(), 1e-300));
+    const double dbTop = 10.0 * std::ceil((peakDb + 3.0) / 10.0);
+    const double dbRange = 80.0;
+
+    batch.add([=](ImDrawList* draw) {
+        const ImU32 gridCol = IM_COL32(60, 60, 60, 255);
+        const ImU32 textCol = IM_COL32(200, 200, 200, 255);
+        draw->AddRectFilled(p0, p1, IM_COL32(25, 25, 25, 255));
+        draw->AddRect(p0, p1, IM_COL32(90, 90, 90, 255));
+        char label[48];
+        for (int gx = 0; gx <= 6; ++gx) {
+            const float t = gx / 6.0f;
+            const float x = left + t * (right - left);
+            draw->AddLine(ImVec2(x, top), ImVec2(x, bottom), gridCol);
+            std::snprintf(label, sizeof(label), "%.1f", t * wMax);
+            draw->AddText(ImVec2(x - 18.0f, bottom + 5.0f), textCol, label);
+        }
+        for (int gy = 0; gy <= 8; ++gy) {
+            const float y = top + gy / 8.0f * (bottom - top);
+            draw->AddLine(ImVec2(left, y), ImVec2(right, y), gridCol);
+            std::snprintf(label, sizeof(label), "%.0f", dbTop - gy * dbRange / 8.0);
+            draw->AddText(ImVec2(p0.x + 5.0f, y - 7.0f), textCol, label);
+        }
+        draw->AddLine(ImVec2(left, bottom), ImVec2(right, bottom), textCol, 1.0f);
+        draw->AddLine(ImVec2(left, top), ImVec2(left, bottom), textCol, 1.0f);
+        draw->AddText(ImVec2(right - 25.0f, bottom + 5.0f), textCol, "w (rad/s)");
+        draw->AddText(ImVec2(left - 35.0f, top - 10.0f), textCol, "dB");
+    });
+    if (K < 2) return;
+
+    auto toPlot = [=, &psd](int k, double v) {
+        const double db = 10.0 * std::log10(std::max(v, 1e-300));
+        const float a = (float)std::clamp((db - (dbTop - dbRange)) / dbRange, 0.0, 1.0);
+        return ImVec2(left + (float)(psd.frequency(k) / wMax) * (right - left), bottom - a * (bottom - top));
+    };
+    const ImU32 band = (color & ~IM_COL32(0, 0, 0, 255)) | IM_COL32(0, 0, 0, 70);
+    batch.addRange(K - 1, [&psd, toPlot, band](ImDrawList* draw, int b, int e) {
+        for (int k = b; k < e; ++k)
+            draw->AddQuadFilled(toPlot(k, psd.lower()[k]), toPlot(k, psd.upper()[k]),
+                toPlot(k + 1, psd.upper()[k + 1]), toPlot(k + 1, psd.lower()[k + 1]), band);
+    });
+    batch.addRange(K - 1, [&psd, toPlot, color](ImDrawList* draw, int b, int e) {
+        for (int k = b; k < e; ++k)
+            draw->AddLine(toPlot(k, psd.power()[k]), toPlot(k + 1, psd.power()[k + 1]), color, 2.0f);
+    });
 }
 
 void Scene::DrawBackground(const ImVec2& windowSize, const AppConfig& cfg) {
     const float centerX = windowSize.x * 0.5f;
     const float centerY = windowSize.y * 0.5f;
     const float step = (cfg.gridScale > 0 ? cfg.gridSpacing * cfg.gridScale : cfg.gridSpacing);
+    const int spacing = cfg.gridSpacing;
 
-    ImDrawList* dl = ImGui::GetBackgroundDrawList();
+    DrawBatch& batch = impl->batch;
+    batch.begin(ImGui::GetBackgroundDrawList());
     auto colGrid = IM_COL32(cfg.gridColor.x * 255, cfg.gridColor.y * 255, cfg.gridColor.z * 255, cfg.gridColor.w * 255);
     auto colAxis = IM_COL32(cfg.axisColor.x * 255, cfg.axisColor.y * 255, cfg.axisColor.z * 255, cfg.axisColor.w * 255);
 
@@ -68,72 +926,160 @@ void Scene::DrawBackground(const ImVec2& windowSize, const AppConfig& cfg) {
     const int nY = int(windowSize.y / step) + 1;
 
     // vertical grid
-    for (int i = -nX; i <= nX; ++i) {
-        float x = centerX + i * step;
-        dl->AddLine(ImVec2(x, 0), ImVec2(x, windowSize.y), colGrid);
-    }
+    batch.addRange(2 * nX + 1, [=](ImDrawList* dl, int b, int e) {
+        for (int i = b - nX; i < e - nX; ++i) {
+            float x = centerX + i * step;
+            dl->AddLine(ImVec2(x, 0), ImVec2(x, windowSize.y), colGrid);
+        }
+    });
     // horizontal grid
-    for (int i = -nY; i <= nY; ++i) {
-        float y = centerY + i * step;
-        dl->AddLine(ImVec2(0, y), ImVec2(windowSize.x, y), colGrid);
-    }
+    batch.addRange(2 * nY + 1, [=](ImDrawList* dl, int b, int e) {
+        for (int i = b - nY; i < e - nY; ++i) {
+            float y = centerY + i * step;
+            dl->AddLine(ImVec2(0, y), ImVec2(windowSize.x, y), colGrid);
+        }
+    });
 
-    // axes
-    dl->AddLine(ImVec2(0, centerY), ImVec2(windowSize.x, centerY), colAxis);
-    dl->AddLine(ImVec2(centerX, 0), ImVec2(centerX, windowSize.y), colAxis);
+    batch.add([=](ImDrawList* dl) {
+        // axes
+        dl->AddLine(ImVec2(0, centerY), ImVec2(windowSize.x, centerY), colAxis);
+        dl->AddLine(ImVec2(centerX, 0), ImVec2(centerX, windowSize.y), colAxis);
 
-    // arrows
-    dl->AddTriangleFilled({ windowSize.x - 10, centerY - 5 }, { windowSize.x, centerY }, { windowSize.x - 10, centerY + 5 }, colAxis);
-    dl->AddTriangleFilled({ centerX - 5, 10 }, { centerX, 0 }, { centerX + 5, 10 }, colAxis);
+        // arrows
+        dl->AddTriangleFilled({ windowSize.x - 10, centerY - 5 }, { windowSize.x, centerY }, { windowSize.x - 10, centerY + 5 }, colAxis);
+        dl->AddTriangleFilled({ centerX - 5, 10 }, { centerX, 0 }, { centerX + 5, 10 }, colAxis);
+    });
 
     // X ticks
-    for (int i = -nX; i <= nX; ++i) {
-        if (i == 0) continue;
-        float x = centerX + i * step;
-        dl->AddLine({ x, centerY - 5 }, { x, centerY + 5 }, colAxis);
-        dl->AddText({ x + 2, centerY + 10 }, colAxis, std::to_string(i * cfg.gridSpacing).c_str());
-    }
+    batch.addRange(2 * nX + 1, [=](ImDrawList* dl, int b, int e) {
+        for (int i = b - nX; i < e - nX; ++i) {
+            if (i == 0) continue;
+            float x = centerX + i * step;
+            dl->AddLine({ x, centerY - 5 }, { x, centerY + 5 }, colAxis);
+            dl->AddText({ x + 2, centerY + 10 }, colAxis, std::to_string(i * spacing).c_str());
+        }
+    }, 512);
     // Y ticks
-    for (int i = -nY; i <= nY; ++i) {
-        if (i == 0) continue;
-        float y = centerY + i * step;
-        dl->AddLine({ centerX - 5, y }, { centerX + 5, y }, colAxis);
-        dl->AddText({ centerX + 10, y - 8 }, colAxis, std::to_string(-i * cfg.gridSpacing).c_str());
-    }
+    batch.addRange(2 * nY + 1, [=](ImDrawList* dl, int b, int e) {
+        for (int i = b - nY; i < e - nY; ++i) {
+            if (i == 0) continue;
+            float y = centerY + i * step;
+            dl->AddLine({ centerX - 5, y }, { centerX + 5, y }, colAxis);
+            dl->AddText({ centerX + 10, y - 8 }, colAxis, std::to_string(-i * spacing).c_str());
+        }
+    }, 512);
+    batch.flush();
 }
 
 void Scene::DrawFunction(const ImVec2& center, const ImVec2& windowSize, const AppConfig& cfg) {
+    PollCompiled();
     const float unit = (cfg.gridScale > 0 ? cfg.gridSpacing * cfg.gridScale : cfg.gridSpacing);
 
     const int nX = int(windowSize.x / unit) + 1;
-    const int N = (cfg.samples > 2 ? cfg.samples : 2);
 
-    std::vector<ImVec2> pts;
-    pts.reserve(N);
+    const float xMin = float(-nX), xMax = float(nX);
+    BeginPass(cfg);
+    SyncVariables(cfg);
+    UpdateProxy(cfg, xMin, xMax);
+    UpdateAutoSamples(cfg, xMin, xMax, unit);
+    const int N = EffectiveSamples(cfg);
+    const std::vector<double>& ys = SampleCurve(xMin, xMax, N);
 
-    for (int i = 0; i < N; ++i) {
-        float t = float(i) / float(N - 1);
-        float x = -nX + t * (2 * nX);
-        float y = Eval(x);
+    // f(x) and the overlay layers share the grid and its screen projection
+    impl->block.setGrid(xMin, xMax, N);
+    SyncLayers(cfg);
+    SampleLayers(cfg);
+    const std::vector<float>& sx = impl->block.screenX(center.x, unit);
+
+    // Everything below is computed here and only tessellated by the batch
+    // jobs, so the buffers they read stay untouched until the flush.
+    DrawBatch& batch = impl->batch;
+    batch.begin(ImGui::GetBackgroundDrawList());
+    const float cy = center.y;
+    // one series on the curve grid
+    auto addSeries = [&](const double* y, ImU32 col, float thickness) {
+        batch.addRange(N - 1, [&sx, y, cy, unit, col, thickness](ImDrawList* dl, int b, int e) {
+            for (int i = b; i < e; ++i)
+                dl->AddLine(ImVec2(sx[i], cy - (float)y[i] * unit),
+                    ImVec2(sx[i + 1], cy - (float)y[i + 1] * unit), col, thickness);
+        });
+    };
+    // a screen-space polyline, broken where y is NaN
+    auto addPolyline = [&](const std::vector<ImVec2>& pts, ImU32 col, float thickness) {
+        batch.addRange((int)pts.size() - 1, [&pts, col, thickness](ImDrawList* dl, int b, int e) {
+            for (int i = b; i < e; ++i) {
+                if (std::isnan(pts[i].y) || std::isnan(pts[i + 1].y)) continue;
+                dl->AddLine(pts[i], pts[i + 1], col, thickness);
+            }
+        });
+    };
 
-        float sx = center.x + x * unit;
-        float sy = center.y - y * unit;
-        pts.emplace_back(sx, sy);
+    if (cfg.quadEnabled) {
+        UpdateIntegral(cfg);
+        const ImVec2 uv = ImGui::GetFontTexUvWhitePixel();
+        batch.add([&, uv](ImDrawList* dl) { DrawIntegral(center, unit, cfg, xMin, xMax, ys, dl, uv); });
     }
 
-    ImDrawList* dl = ImGui::GetBackgroundDrawList();
-    for (int i = 1; i < N; ++i) {
-        dl->AddLine(pts[i - 1], pts[i], RGBA(cfg.funcColor), 2.0f);
+    for (int k = 0; k < impl->block.layers(); ++k) {
+        if (!impl->layers[k].prog || !cfg.layers[k].visible) continue;
+        addSeries(impl->block.row(k), RGBA(cfg.layers[k].color), 2.0f);
+    }
+    std::vector<ImVec2> refined;
+    if (cfg.intervalPlot && impl->prog->treeValid) {
+        addPolyline(TraceCurve(center, windowSize, unit, xMin, xMax, N), RGBA(cfg.funcColor), 2.0f);
+    }
+    else if (cfg.adaptiveCurve) {
+        const auto& world = RefineCurve(xMin, xMax, unit, ys);
+        refined.resize(world.size());
+        for (size_t i = 0; i < world.size(); ++i)
+            refined[i] = ImVec2(center.x + world[i].x * unit, center.y - world[i].y * unit);
+        addPolyline(refined, RGBA(cfg.funcColor), 2.0f);
+    }
+    else {
+        addSeries(ys.data(), RGBA(cfg.funcColor), 2.0f);
+    }
+
+    if (cfg.showDerivative1 || cfg.showDerivative2) {
+        UpdateDerivatives(xMin, xMax, ys);
+        if (cfg.showDerivative1) addSeries(impl->derivY1.data(), RGBA(cfg.derivColor1), 1.5f);
+        if (cfg.showDerivative2) addSeries(impl->derivY2.data(), RGBA(cfg.derivColor2), 1.5f);
+    }
+
+    if (cfg.showRoots || cfg.showExtrema || cfg.showAsymptotes) {
+        UpdateAnnotations(xMin, xMax, ys);
+        batch.add([&](ImDrawList* dl) { DrawAnnotations(center, windowSize, unit, cfg, dl); });
+    }
+
+    if (cfg.filterEnabled) {
+        const double dx = double(xMax - xMin) / (N - 1);
+        addSeries(FilterSignal(ys, dx, cfg, false).data(), RGBA(cfg.filterColor), 2.0f);
+    }
+
+    if (cfg.reconEnabled) {
+        if (impl->reconGeneration != impl->curveGeneration) {
+            impl->recon.setSignal(ys);
+            impl->reconGeneration = impl->curveGeneration;
+        }
+        addSeries(impl->recon.reconstruct(cfg.reconTerms).data(), RGBA(cfg.reconColor), 1.5f);
     }
+    batch.flush();
+    EndPass(cfg);
 }
 
 void Scene::DrawFourierTransform(const ImVec2& center,
     const ImVec2& windowSize,
     const AppConfig& cfg)
 {
+    PollCompiled();
     const float unitScale = (cfg.gridScale > 0 ? cfg.gridSpacing * cfg.gridScale : cfg.gridSpacing);
-    const int sampleCount = (cfg.samples > 2 ? cfg.samples : 2);
     ImDrawList* drawList = ImGui::GetBackgroundDrawList();
+    BeginPass(cfg);
+    SyncVariables(cfg);
+    // the transform samples its own window, the other views reuse the plotted curve
+    const bool spectrumView = cfg.fourierDisplayMode == FOURIER_TRANSFORM;
+    const int plotHalfSpan = int(windowSize.x / unitScale) + 1;
+    UpdateAutoSamples(cfg, (float)-plotHalfSpan, (float)plotHalfSpan, unitScale);
+    const int sampleCount = EffectiveSamples(cfg, spectrumView);
 
     auto toScreen = [&](float worldX, float worldY) -> ImVec2 {
         return ImVec2(center.x + worldX * unitScale, center.y - worldY * unitScale);
@@ -170,8 +1116,7 @@ void Scene::DrawFourierTransform(const ImVec2& center,
                 RGBA(cfg.fourierRangeColor), bracketThickness);
         }
 
-        auto spec = F.computeTransform([&](double x) { return Eval((float)x); },
-            cfg.fourierCenter, cfg.fourierRange, sampleCount);
+        const FourierSpectrum& spec = TransformSpectrum(cfg, sampleCount);
 
         ImGui::Begin("Fourier Transform");
         ImGui::Text("Samples: %d | Range: [%.3f, %.3f] rad/s | Max amplitude: %.4f",
@@ -181,13 +1126,108 @@ void Scene::DrawFourierTransform(const ImVec2& center,
         ImGui::InvisibleButton("FourierCanvas", canvasSize);
         ImVec2 p0 = ImGui::GetItemRectMin();
         ImVec2 p1 = ImGui::GetItemRectMax();
-        ImDrawList* draw = ImGui::GetWindowDrawList();
-        draw->AddRectFilled(p0, p1, IM_COL32(25, 25, 25, 255));
-        draw->AddRect(p0, p1, IM_COL32(90, 90, 90, 255));
+        DrawBatch& batch = impl->batch;
+        batch.begin(ImGui::GetWindowDrawList());
+        const ImU32 color = RGBA(cfg.fourierColor);
+        batch.add([&F, &spec, p0, p1, color](ImDrawList* draw) {
+            draw->AddRectFilled(p0, p1, IM_COL32(25, 25, 25, 255));
+            draw->AddRect(p0, p1, IM_COL32(90, 90, 90, 255));
+            F.renderTransform(spec, p0, p1, draw, color);
+        });
+
+        if (cfg.filterEnabled) {
+            const FourierSpectrum& filtered = FilteredSpectrum(cfg, sampleCount);
+            const ImU32 overlay = RGBA(cfg.filterColor);
+            batch.add([&filtered, &spec, p0, p1, overlay](ImDrawList* draw) {
+                DrawSpectrumOverlay(filtered, spec.maxAmp, p0, p1, draw, overlay);
+            });
+        }
+        batch.flush();
+        ImGui::End();
+    }
+    else if (cfg.fourierDisplayMode == FOURIER_SCALOGRAM)
+    {
+        // CWT of the plotted curve, time axis = visible x range
+        int halfSpanUnits = int(windowSize.x / unitScale) + 1;
+        const float xMin = (float)-halfSpanUnits, xMax = (float)halfSpanUnits;
+        const auto& ys = SampleCurve(xMin, xMax, sampleCount);
+        const double dx = double(xMax - xMin) / (sampleCount - 1);
+
+        impl->scalogram.compute(ys, impl->curveGeneration, dx, cfg.cwtWavelet,
+            cfg.cwtFreqMin, cfg.cwtFreqMax, cfg.cwtScales);
 
-        F.renderTransform(spec, p0, p1, draw, RGBA(cfg.fourierColor));
+        ImGui::Begin("Scalogram");
+        ImGui::Text("Scales: %d | Range: [%.3f, %.3f] rad/s | x: [%.1f, %.1f]",
+            impl->scalogram.scales(), cfg.cwtFreqMin, cfg.cwtFreqMax, xMin, xMax);
+        const ImVec2 canvasSize(ImGui::GetContentRegionAvail().x, 260.0f);
+        ImGui::InvisibleButton("ScalogramCanvas", canvasSize);
+        impl->batch.begin(ImGui::GetWindowDrawList());
+        DrawScalogram(impl->scalogram, ImGui::GetItemRectMin(), ImGui::GetItemRectMax(), impl->batch);
+        impl->batch.flush();
+        ImGui::End();
+    }
+    else if (cfg.fourierDisplayMode == FOURIER_PSD)
+    {
+        // Welch estimate over the plotted curve, same samples as the scalogram
+        int halfSpanUnits = int(windowSize.x / unitScale) + 1;
+        const float xMin = (float)-halfSpanUnits, xMax = (float)halfSpanUnits;
+        const auto& ys = SampleCurve(xMin, xMax, sampleCount);
+        const double dx = double(xMax - xMin) / (sampleCount - 1);
+
+        WelchPSD& psd = impl->psd;
+        psd.compute(ys, impl->curveGeneration, dx, cfg.psdSegments, cfg.psdOverlap);
+
+        ImGui::Begin("Power Spectral Density");
+        ImGui::Text("Segments: %d x %d samples (hop %d) | dof: %.1f | Range: [0, %.3f] rad/s",
+            psd.segments(), psd.segmentLength(), psd.hop(), psd.dof(),
+            psd.bins() > 0 ? psd.frequency(psd.bins() - 1) : 0.0);
+        const ImVec2 canvasSize(ImGui::GetContentRegionAvail().x, 260.0f);
+        ImGui::InvisibleButton("PSDCanvas", canvasSize);
+        impl->batch.begin(ImGui::GetWindowDrawList());
+        DrawPSD(psd, ImGui::GetItemRectMin(), ImGui::GetItemRectMax(), RGBA(cfg.fourierColor), impl->batch);
+        impl->batch.flush();
         ImGui::End();
     }
+    else if (cfg.fourierDisplayMode == FOURIER_ANALYTIC)
+    {
+        // envelope and phase or frequency of the plotted curve, over the curve
+        int halfSpanUnits = int(windowSize.x / unitScale) + 1;
+        const float xMin = (float)-halfSpanUnits, xMax = (float)halfSpanUnits;
+        const auto& ys = SampleCurve(xMin, xMax, sampleCount);
+        const double dx = double(xMax - xMin) / (sampleCount - 1);
+
+        const AnalyticSignal& as = impl->analytic;
+        impl->analytic.compute(ys, impl->curveGeneration, dx);
+        const int N = as.length();
+        const double mean = as.mean();
+        const ImVec2 c = center;
+        const float u = unitScale;
+
+        DrawBatch& batch = impl->batch;
+        batch.begin(drawList);
+        // upper and lower envelope around the mean
+        const ImU32 envColor = RGBA(cfg.fourierColor);
+        for (const double sign : { 1.0, -1.0 }) {
+            batch.addRange(N - 1, [&as, sign, mean, xMin, dx, c, u, envColor](ImDrawList* dl, int b, int e) {
+                auto at = [&](int i) {
+                    return ImVec2(c.x + (float)(xMin + i * dx) * u, c.y - (float)(mean + sign * as.envelope()[i]) * u);
+                };
+                for (int i = b; i < e; ++i) dl->AddLine(at(i), at(i + 1), envColor, 2.0f);
+            });
+        }
+        const std::vector<double>* track = cfg.hilbertTrack == HILBERT_PHASE ? &as.phaseTrack()
+            : cfg.hilbertTrack == HILBERT_FREQUENCY ? &as.frequency() : nullptr;
+        if (track) {
+            const ImU32 trackColor = RGBA(cfg.hilbertColor);
+            batch.addRange(N - 1, [track, xMin, dx, c, u, trackColor](ImDrawList* dl, int b, int e) {
+                auto at = [&](int i) {
+                    return ImVec2(c.x + (float)(xMin + i * dx) * u, c.y - (float)(*track)[i] * u);
+                };
+                for (int i = b; i < e; ++i) dl->AddLine(at(i), at(i + 1), trackColor, 1.5f);
+            });
+        }
+        batch.flush();
+    }
     else // FOURIER_MODULATED_SIGNAL
     {
         int halfSpanUnits = int(windowSize.x / unitScale) + 1;
@@ -198,16 +1238,222 @@ void Scene::DrawFourierTransform(const ImVec2& center,
             [&](double x) { return Eval((float)x); },
             cfg.fourierMode, toScreen);
 
-        for (int i = 1; i < sampleCount; ++i)
-            drawList->AddLine(points[i - 1], points[i], RGBA(cfg.fourierColor), 2.0f);
+        const ImU32 color = RGBA(cfg.fourierColor);
+        impl->batch.begin(drawList);
+        impl->batch.addRange(sampleCount - 1, [&points, color](ImDrawList* dl, int b, int e) {
+            for (int i = b; i < e; ++i) dl->AddLine(points[i], points[i + 1], color, 2.0f);
+        });
+        impl->batch.flush();
+    }
+    EndPass(cfg, spectrumView);
+}
+
+
+const FourierSpectrum& Scene::TransformSpectrum(const AppConfig& cfg, int N) {
+    Impl& m = *impl;
+    const Program& p = *m.prog;
+    const bool varying = Impl::Varying(p);
+    if (m.spectrumVersion != m.exprVersion || (varying && m.spectrumVarsVersion != m.varsVersion) ||
+        m.spectrumN != N || m.spectrumCenter != cfg.fourierCenter || m.spectrumRange != cfg.fourierRange)
+    {
+        CachedSpectrum& s = m.seed.spectrum;
+        if (!s.source.empty() && s.source == p.key && s.n == N && s.center == cfg.fourierCenter &&
+            s.range == cfg.fourierRange && (!varying || m.SameParams(s.params))) {
+            m.spectrum = std::move(s.spectrum);
+            m.spectrumWindow.clear();
+            s = CachedSpectrum();
+        }
+        else {
+            // computeTransform samples the window in order, keep them for the filter overlay
+            m.spectrumWindow.resize(N);
+            int n = 0;
+            m.spectrum = Fourier(N).computeTransform([&](double x) {
+                const double y = Eval((float)x);
+                m.spectrumWindow[n++] = y;
+                return y;
+            }, cfg.fourierCenter, cfg.fourierRange, N);
+        }
+        ++m.spectrumGeneration;
+        // passes cut short by the budget or served by the Chebyshev proxy are not kept
+        m.spectrumVersion = (m.guard.tripped || m.proxyActive) ? ~0u : m.exprVersion;
+        m.spectrumVarsVersion = m.varsVersion;
+        m.spectrumN = N;
+        m.spectrumCenter = cfg.fourierCenter;
+        m.spectrumRange = cfg.fourierRange;
+    }
+    return m.spectrum;
+}
+
+const FourierSpectrum& Scene::FilteredSpectrum(const AppConfig& cfg, int N) {
+    Impl& m = *impl;
+    TransformSpectrum(cfg, N);
+
+    FilterSpec spec;
+    spec.type = cfg.filterType;
+    spec.low = cfg.filterLow;
+    spec.high = cfg.filterHigh;
+    spec.width = cfg.filterWidth;
+    if (cfg.filterType == FILTER_KERNEL) spec.kernelExpr = cfg.filterKernel;
+
+    // an unkept spectrum is redone every pass, so is its overlay
+    if (m.filteredGeneration != m.spectrumGeneration || !(m.filteredSpec == spec) || m.spectrumVersion == ~0u) {
+        const double dt = 2.0 * cfg.fourierRange / N;
+        if ((int)m.spectrumWindow.size() != N) {
+            // seeded spectrum: sample the window once, the same points computeTransform takes
+            const double start = cfg.fourierCenter - cfg.fourierRange;
+            m.spectrumWindow.resize(N);
+            for (int n = 0; n < N; ++n) m.spectrumWindow[n] = Eval((float)(start + n * dt));
+        }
+        m.filteredSpectrum = spectrumOf(FilterSignal(m.spectrumWindow, dt, cfg, true), dt);
+        m.filteredGeneration = m.spectrumGeneration;
+        m.filteredSpec = spec;
     }
+    return m.filteredSpectrum;
+}
+
+void Scene::ExportCache(WorkspaceCache& ws) const {
+    const Impl& m = *impl;
+    auto entry = [&](CachedSamples& e, const Program& p, double xMin, double xMax, const double* ys, int n) {
+        e.source = p.key;
+        std::copy(m.params, m.params + kVarCount - 1, e.params);
+        e.n = n;
+        e.xMin = xMin;
+        e.xMax = xMax;
+        e.values.assign(ys, ys + n);
+    };
+
+    ws.curve = CachedSamples();
+    if (m.prog->valid && m.curveExact && m.curveVersion == m.exprVersion && m.curveVarsVersion == m.varsVersion)
+        entry(ws.curve, *m.prog, m.curveMin, m.curveMax, m.curveY.data(), m.curveN);
+
+    ws.layers.assign(m.layers.size(), CachedSamples());
+    const LayerBlock& block = m.block;
+    for (int k = 0; k < block.layers() && k < (int)m.layers.size(); ++k) {
+        const Impl::Layer& layer = m.layers[k];
+        const int n = block.samples();
+        if (!layer.prog || n < 2 || block.dirty(k) || (layer.varying && layer.varsVersion != m.varsVersion)) continue;
+        entry(ws.layers[k], *layer.prog, block.x(0), block.x(n - 1), block.row(k), n);
+    }
+
+    ws.spectrum = CachedSpectrum();
+    if (m.prog->valid && m.spectrumVersion == m.exprVersion &&
+        (!Impl::Varying(*m.prog) || m.spectrumVarsVersion == m.varsVersion)) {
+        CachedSpectrum& s = ws.spectrum;
+        s.source = m.prog->key;
+        std::copy(m.params, m.params + kVarCount - 1, s.params);
+        s.center = m.spectrumCenter;
+        s.range = m.spectrumRange;
+        s.n = m.spectrumN;
+        s.spectrum = m.spectrum;
+    }
+}
+
+void Scene::ImportCache(const WorkspaceCache& ws) {
+    impl->seed = ws;
+    impl->seed.config.clear();
+}
+
+void Scene::FinishCompiling() {
+    impl->cache.Wait();
+    PollCompiled();
+}
+
+bool Scene::FinishCompiling(double timeoutMs) {
+    const bool idle = impl->cache.WaitFor(timeoutMs);
+    PollCompiled();
+    return idle;
+}
+
+std::vector<double> Scene::SampleFunction(const AppConfig& cfg, float xMin, float xMax, int N) {
+    PollCompiled();
+    BeginPass(cfg);
+    SyncVariables(cfg);
+    UpdateProxy(cfg, xMin, xMax);
+    std::vector<double> ys = SampleCurve(xMin, xMax, std::max(N, 2));
+    EndPass(cfg);
+    return ys;
 }
 
+FourierSpectrum Scene::ComputeSpectrum(const AppConfig& cfg, int N) {
+    PollCompiled();
+    BeginPass(cfg);
+    SyncVariables(cfg);
+    Fourier F(N);
+    FourierSpectrum spec = F.computeTransform([&](double x) { return Eval((float)x); },
+        cfg.fourierCenter, cfg.fourierRange, N);
+    EndPass(cfg);
+    return spec;
+}
 
 bool Scene::HasError() const {
-    return !impl->valid;
+    return impl->hasError;
+}
+
+bool Scene::IsCompiling() const {
+    return !impl->pending.empty();
+}
+
+const ExprCache& Scene::GetCache() const {
+    return impl->cache;
 }
 
 const std::string& Scene::GetLastError() const {
     return impl->lastError;
+}
+
+bool Scene::LayerHasError(int k) const {
+    return k < (int)impl->layers.size() && impl->layers[k].hasError;
+}
+
+const std::string& Scene::GetLayerError(int k) const {
+    static const std::string none;
+    return k < (int)impl->layers.size() ? impl->layers[k].error : none;
+}
+
+bool Scene::IsLayerCompiling(int k) const {
+    return k < (int)impl->layers.size() && !impl->layers[k].pending.empty();
+}
+
+const std::string& Scene::GetFilterError() const {
+    return impl->kernelError;
+}
+
+const PartialReconstruction& Scene::GetReconstruction() const {
+    return impl->recon;
+}
+
+const QuadResult& Scene::GetIntegral() const {
+    return impl->quad;
+}
+
+bool Scene::HasExprTree() const {
+    return impl->prog->treeValid;
+}
+
+const TraceStats& Scene::GetTraceStats() const {
+    return impl->traceStats;
+}
+
+const ChebProxy& Scene::GetProxy() const {
+    return impl->proxy;
+}
+
+const ColumnEval& Scene::GetColumns() const {
+    return impl->columns;
+}
+
+const ExprProfile& Scene::GetProfile() const {
+    return impl->prog->profile;
+}
+
+int Scene::GetSampleLimit() const {
+    return impl->sampleLimit;
+}
+
+bool Scene::WasAborted() const {
+    return impl->lastAborted;
+}
+
+const AutoSamples& Scene::GetAutoSamples() const {
+    return impl->autoN;
 }
\ No newline at end of file
@@ -1,8 +1,18 @@
 #pragma once
 #include <string>
 #include "Config.h"
+#include "Reconstruction.h"
+#include "Quadrature.h"
+#include "IntervalPlot.h"
+#include "Chebyshev.h"
+#include "ColumnEval.h"
+#include "ExprCache.h"
+#include "Bandwidth.h"
 #include <imgui/imgui.h>
 #include <memory>
+#include <vector>
+
+struct WorkspaceCache;
 
 class Scene {
 public:
@@ -14,11 +24,101 @@ public:
     void DrawFunction(const ImVec2& center, const ImVec2& windowSize, const AppConfig& cfg);
     void DrawFourierTransform(const ImVec2& center, const ImVec2& windowSize, const AppConfig& cfg);
 
+    // the latest source failed to compile (the previous one keeps drawing)
     bool HasError() const;
+
+    // Headless use (batch export), no ImGui frame needed:
+    // block until the sources set so far are compiled and installed
+    void FinishCompiling();
+    // same, waiting at most timeoutMs; false when a compile is still running
+    // (its program is installed by a later frame)
+    bool FinishCompiling(double timeoutMs);
+    // f at N uniform points of [xMin, xMax] with cfg's t and a..d, one budgeted pass
+    std::vector<double> SampleFunction(const AppConfig& cfg, float xMin, float xMax, int N);
+    // centered spectrum of f over fourierCenter +- fourierRange, as in the transform view
+    FourierSpectrum ComputeSpectrum(const AppConfig& cfg, int N);
+    // Workspace snapshot: results whose inputs are still current, and seeding
+    // the caches from them. A seeded entry replaces the computation the first
+    // time exactly its inputs (expression, t and a..d, grid) come up again.
+    void ExportCache(WorkspaceCache& ws) const;
+    void ImportCache(const WorkspaceCache& ws);
+    // a source is compiling in the background
+    bool IsCompiling() const;
+    const ExprCache& GetCache() const;
+    // overlay layer k (cfg.layers[k]): compile state; RemoveLayer keeps the other layers' caches
+    bool LayerHasError(int k) const;
+    const std::string& GetLayerError(int k) const;
+    bool IsLayerCompiling(int k) const;
+    void RemoveLayer(int k);
     const std::string& GetLastError() const;
+    const std::string& GetFilterError() const;
+    const PartialReconstruction& GetReconstruction() const;
+    const QuadResult& GetIntegral() const;
+    // true when f lies inside the ExprTree subset (exact derivatives, interval bounds)
+    bool HasExprTree() const;
+    // cell counts of the last interval trace of f(x)
+    const TraceStats& GetTraceStats() const;
+    // Chebyshev proxy of f over the plotted range (empty while disabled)
+    const ChebProxy& GetProxy() const;
+    // incremental evaluator of the curve grid (node counts of the last pass)
+    const ColumnEval& GetColumns() const;
+    const ExprProfile& GetProfile() const;
+    // largest N a pass fits into the evaluation budget, and whether the last pass was cut short
+    int GetSampleLimit() const;
+    bool WasAborted() const;
+    // sample counts the auto-N mode picked for the last frame
+    const AutoSamples& GetAutoSamples() const;
 
 private:
     float Eval(float x);
+    // make a compiled program current; its cost profile seeds the sample limit
+    void Install(const std::shared_ptr<Program>& p);
+    void InstallLayer(int k, const std::shared_ptr<Program>& p);
+    // install pending sources (f(x) and layers) whose compile finished
+    void PollCompiled();
+    // follow cfg.layers: resize, request changed sources
+    void SyncLayers(const AppConfig& cfg);
+    // resample the dirty rows of the layer block
+    void SampleLayers(const AppConfig& cfg);
+    // auto-N: bandwidth of f over the plotted range and the transform window
+    void UpdateAutoSamples(const AppConfig& cfg, float xMin, float xMax, float unit);
+    // cfg.samples, or the auto-N choice for the curve or the spectrum
+    int RequestedSamples(const AppConfig& cfg, bool spectrum) const;
+    // the requested N clamped to what the evaluation budget allows
+    int EffectiveSamples(const AppConfig& cfg, bool spectrum = false) const;
+    // arm / disarm the evaluation guard around one drawing pass
+    void BeginPass(const AppConfig& cfg);
+    void EndPass(const AppConfig& cfg, bool spectrum = false);
+    // push t and a..d from the config into the evaluators, marking dependents stale
+    void SyncVariables(const AppConfig& cfg);
+
+    // refit the Chebyshev proxy when the expression or the plotted range changes
+    void UpdateProxy(const AppConfig& cfg, float xMin, float xMax);
+    // transform-view spectrum of f, reused until its inputs change
+    const FourierSpectrum& TransformSpectrum(const AppConfig& cfg, int N);
+    // the same window samples filtered then transformed, reused until the spectrum or the filter change
+    const FourierSpectrum& FilteredSpectrum(const AppConfig& cfg, int N);
+    // uniform samples of f over [xMin, xMax], reused until the inputs change
+    const std::vector<double>& SampleCurve(float xMin, float xMax, int N);
+    // filtering stage: filtered copy of uniformly spaced samples
+    const std::vector<double>& FilterSignal(const std::vector<double>& signal, double dx,
+        const AppConfig& cfg, bool spectrum);
+    // integral of f over [quadA, quadB], cached per expression and bounds
+    void UpdateIntegral(const AppConfig& cfg);
+    // draws into dl (a batch job); uv is the font atlas white pixel
+    void DrawIntegral(const ImVec2& center, float unit, const AppConfig& cfg,
+        float xMin, float xMax, const std::vector<double>& ys, ImDrawList* dl, const ImVec2& uv) const;
+    // f' and f'' on the curve grid, cached with the samples
+    void UpdateDerivatives(float xMin, float xMax, const std::vector<double>& ys);
+    // curve polyline with extra points where the curvature makes chords visible
+    const std::vector<ImVec2>& RefineCurve(float xMin, float xMax, float unit, const std::vector<double>& ys);
+    // interval-traced polyline of f(x) in screen space, NaN y between pieces
+    const std::vector<ImVec2>& TraceCurve(const ImVec2& center, const ImVec2& windowSize, float unit,
+        float xMin, float xMax, int N);
+    // roots, extrema and poles of the sampled curve, cached per expression and viewport
+    void UpdateAnnotations(float xMin, float xMax, const std::vector<double>& ys);
+    void DrawAnnotations(const ImVec2& center, const ImVec2& windowSize, float unit,
+        const AppConfig& cfg, ImDrawList* dl) const;
 
     struct Impl;
     std::unique_ptr<Impl> impl;
@@ -0,0 +1,199 @@
+#include "SoftRaster.h"
+#include "ThreadPool.h"
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+namespace {
+
+struct Vert {
+    float x, y, u, v;
+    float c[4];   // straight RGBA, 0..1
+};
+
+struct Cmd {
+    float x0, y0, x1, y1;   // clip rect in output pixels
+    bool textured;
+};
+
+struct Tri {
+    uint32_t v[3];
+    int cmd;
+    float x0, y0, x1, y1;   // bounds, already clipped
+};
+
+class Raster {
+public:
+    Raster(const ImDrawData& data, float scale, const RasterTexture& font) : font_(font) {
+        for (int n = 0; n < data.CmdListsCount; ++n) {
+            const ImDrawList* list = data.CmdLists[n];
+            const uint32_t base = (uint32_t)verts_.size();
+            for (const ImDrawVert& dv : list->VtxBuffer) {
+                Vert v;
+                v.x = (dv.pos.x - data.DisplayPos.x) * scale;
+                v.y = (dv.pos.y - data.DisplayPos.y) * scale;
+                v.u = dv.uv.x;
+                v.v = dv.uv.y;
+                for (int k = 0; k < 4; ++k) v.c[k] = ((dv.col >> (8 * k)) & 0xFF) / 255.0f;
+                verts_.push_back(v);
+            }
+            for (const ImDrawCmd& dc : list->CmdBuffer) {
+                if (dc.UserCallback) continue;
+                Cmd c;
+                c.x0 = (dc.ClipRect.x - data.DisplayPos.x) * scale;
+                c.y0 = (dc.ClipRect.y - data.DisplayPos.y) * scale;
+                c.x1 = (dc.ClipRect.z - data.DisplayPos.x) * scale;
+                c.y1 = (dc.ClipRect.w - data.DisplayPos.y) * scale;
+                c.textured = font_.rgba && dc.TextureId == font_.id;
+                const int ci = (int)cmds_.size();
+                cmds_.push_back(c);
+                for (unsigned e = 0; e + 2 < dc.ElemCount; e += 3) {
+                    Tri t;
+                    t.cmd = ci;
+                    for (int k = 0; k < 3; ++k)
+                        t.v[k] = base + dc.VtxOffset + list->IdxBuffer[(int)(dc.IdxOffset + e + k)];
+                    const Vert &a = verts_[t.v[0]], &b = verts_[t.v[1]], &d = verts_[t.v[2]];
+                    t.x0 = std::max(c.x0, std::min({ a.x, b.x, d.x }));
+                    t.y0 = std::max(c.y0, std::min({ a.y, b.y, d.y }));
+                    t.x1 = std::min(c.x1, std::max({ a.x, b.x, d.x }));
+                    t.y1 = std::min(c.y1, std::max({ a.y, b.y, d.y }));
+                    if (t.x1 > t.x0 && t.y1 > t.y0) tris_.push_back(t);
+                }
+            }
+        }
+    }
+
+    // Triangles touching rows [y0, y1), in draw order
+    void band(int y0, int y1, std::vector<uint32_t>& out) const {
+        out.clear();
+        for (uint32_t i = 0; i < (uint32_t)tris_.size(); ++i)
+            if (tris_[i].y1 > y0 && tris_[i].y0 < y1) out.push_back(i);
+    }
+
+    // Rasterize the band's triangles into a w x h tile at (tx, ty), RGBA floats
+    void tile(const std::vector<uint32_t>& bandTris, int tx, int ty, int w, int h, float* px) const {
+        for (uint32_t ti : bandTris) {
+            const Tri& t = tris_[ti];
+            if (t.x1 <= tx || t.x0 >= tx + w) continue;
+            const int xa = std::max(tx, (int)std::floor(t.x0)), xb = std::min(tx + w, (int)std::ceil(t.x1));
+            const int ya = std::max(ty, (int)std::floor(t.y0)), yb = std::min(ty + h, (int)std::ceil(t.y1));
+            if (xa >= xb || ya >= yb) continue;
+            triangle(t, xa, xb, ya, yb, tx, ty, w, px);
+        }
+    }
+
+private:
+    void sample(float u, float v, float out[4]) const {
+        const float fx = u * font_.width - 0.5f, fy = v * font_.height - 0.5f;
+        const int x0 = (int)std::floor(fx), y0 = (int)std::floor(fy);
+        const float ax = fx - x0, ay = fy - y0;
+        auto texel = [&](int x, int y, int k) -> float {
+            x = std::clamp(x, 0, font_.width - 1);
+            y = std::clamp(y, 0, font_.height - 1);
+            return font_.rgba[(size_t(y) * font_.width + x) * 4 + k];
+        };
+        for (int k = 0; k < 4; ++k) {
+            const float top = texel(x0, y0, k) * (1 - ax) + texel(x0 + 1, y0, k) * ax;
+            const float bot = texel(x0, y0 + 1, k) * (1 - ax) + texel(x0 + 1, y0 + 1, k) * ax;
+            out[k] = (top * (1 - ay) + bot * ay) / 255.0f;
+        }
+    }
+
+    void triangle(const Tri& t, int xa, int xb, int ya, int yb, int tx, int ty, int w, float* px) const {
+        const Vert* v[3] = { &verts_[t.v[0]], &verts_[t.v[1]], &verts_[t.v[2]] };
+        float area = (v[1]->x - v[0]->x) * (v[2]->y - v[0]->y) - (v[2]->x - v[0]->x) * (v[1]->y - v[0]->y);
+        if (std::fabs(area) < 1e-12f) return;
+        if (area < 0) { std::swap(v[1], v[2]); area = -area; }
+        const float inv = 1.0f / area;
+        const bool textured = cmds_[t.cmd].textured;
+
+        // top-left rule, so pixels on an edge shared by two triangles are blended once
+        bool topLeft[3];
+        for (int i = 0; i < 3; ++i) {
+            const Vert& a = *v[(i + 1) % 3];
+            const Vert& b = *v[(i + 2) % 3];
+            const float dx = b.x - a.x, dy = b.y - a.y;
+            topLeft[i] = (dy == 0 && dx > 0) || dy < 0;
+        }
+
+        for (int y = ya; y < yb; ++y) {
+            const float cy = y + 0.5f;
+            float* row = px + (size_t(y - ty) * w) * 4;
+            for (int x = xa; x < xb; ++x) {
+                const float cx = x + 0.5f;
+                float e[3];
+                for (int i = 0; i < 3; ++i) {
+                    const Vert& a = *v[(i + 1) % 3];
+                    const Vert& b = *v[(i + 2) % 3];
+                    e[i] = (b.x - a.x) * (cy - a.y) - (b.y - a.y) * (cx - a.x);
+                }
+                bool inside = true;
+                for (int i = 0; i < 3 && inside; ++i)
+                    inside = e[i] > 0 || (e[i] == 0 && topLeft[i]);
+                if (!inside) continue;
+
+                const float w0 = e[0] * inv, w1 = e[1] * inv, w2 = 1.0f - w0 - w1;
+                float c[4];
+                for (int k = 0; k < 4; ++k) c[k] = v[0]->c[k] * w0 + v[1]->c[k] * w1 + v[2]->c[k] * w2;
+                if (textured) {
+                    float tex[4];
+                    sample(v[0]->u * w0 + v[1]->u * w1 + v[2]->u * w2,
+                        v[0]->v * w0 + v[1]->v * w1 + v[2]->v * w2, tex);
+                    for (int k = 0; k < 4; ++k) c[k] *= tex[k];
+                }
+                const float a = std::clamp(c[3], 0.0f, 1.0f);
+                if (a <= 0.0f) continue;
+                float* d = row + size_t(x - tx) * 4;
+                for (int k = 0; k < 3; ++k) d[k] = c[k] * a + d[k] * (1.0f - a);
+                d[3] = a + d[3] * (1.0f - a);
+            }
+        }
+    }
+
+    const RasterTexture& font_;
+    std::vector<Vert> verts_;
+    std::vector<Cmd> cmds_;
+    std::vector<Tri> tris_;
+};
+
+} // namespace
+
+bool RasterizeDrawData(const ImDrawData& data, float scale, const RasterTexture& font,
+    const ImVec4& clear, PngWriter& png, int tileSize)
+{
+    const int W = png.width(), H = png.height();
+    if (W <= 0 || H <= 0) return false;
+    tileSize = std::max(16, tileSize);
+    const Raster raster(data, scale, font);
+
+    const int tilesX = (W + tileSize - 1) / tileSize;
+    std::vector<uint8_t> band(size_t(W) * tileSize * 4);
+    std::vector<uint32_t> bandTris;
+    const float clearRGBA[4] = { clear.x, clear.y, clear.z, clear.w };
+
+    for (int by = 0; by < H; by += tileSize) {
+        const int bh = std::min(tileSize, H - by);
+        raster.band(by, by + bh, bandTris);
+
+        ThreadPool::Shared().parallelFor(0, tilesX, [&](int i) {
+            const int tx = i * tileSize;
+            const int tw = std::min(tileSize, W - tx);
+            thread_local std::vector<float> px;
+            px.resize(size_t(tw) * bh * 4);
+            for (size_t p = 0; p < px.size(); p += 4)
+                for (int k = 0; k < 4; ++k) px[p + k] = clearRGBA[k];
+
+            raster.tile(bandTris, tx, by, tw, bh, px.data());
+
+            for (int y = 0; y < bh; ++y) {
+                const float* src = px.data() + size_t(y) * tw * 4;
+                uint8_t* dst = band.data() + (size_t(y) * W + tx) * 4;
+                for (int k = 0; k < tw * 4; ++k)
+                    dst[k] = (uint8_t)(std::clamp(src[k], 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+        });
+        if (!png.writeRows(band.data(), bh)) return false;
+    }
+    return png.close();
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <imgui/imgui.h>
+#include "PngWriter.h"
+
+// Pixels of the texture the draw commands sample (the font atlas), RGBA32 as
+// ImFontAtlas::GetTexDataAsRGBA32 returns them
+struct RasterTexture {
+    ImTextureID id = ImTextureID();
+    const unsigned char* rgba = nullptr;
+    int width = 0, height = 0;
+};
+
+// CPU backend for ImDrawData. Triangles are drawn with their vertex colors,
+// the font texture and the command clip rects, at `scale` times their logical
+// coordinates, so the same geometry renders at any resolution. The image is
+// split into square tiles; one row of tiles (a band) is rasterized in
+// parallel and streamed to `png` before the next, so memory stays at one band.
+// Lines are as smooth as ImGui's anti-aliasing fringe makes them: draw with
+// a fringe of 1 / scale so it spans one output pixel.
+// The output size is the size `png` was opened with.
+bool RasterizeDrawData(const ImDrawData& data, float scale, const RasterTexture& font,
+    const ImVec4& clear, PngWriter& png, int tileSize = 256);
@@ -0,0 +1,89 @@
+#include "ThreadPool.h"
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned workers) {
+    for (unsigned i = 0; i < workers; ++i)
+        m_workers.emplace_back([this] { WorkerLoop(); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto& t : m_workers) t.join();
+}
+
+ThreadPool& ThreadPool::Shared() {
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+void ThreadPool::WorkerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+            if (m_stop && m_tasks.empty()) return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_cv.notify_one();
+}
+
+void ThreadPool::parallelFor(int begin, int end, const std::function<void(int)>& fn) {
+    const int count = end - begin;
+    if (count <= 0) return;
+    const int helpers = std::min((int)m_workers.size(), count - 1);
+    if (helpers <= 0) {
+        for (int i = begin; i < end; ++i) fn(i);
+        return;
+    }
+
+    // Shared with helpers that may only get scheduled after the loop is over;
+    // those see next >= end and leave without touching fn.
+    struct State {
+        std::atomic<int> next;
+        std::atomic<int> active{ 0 };
+        int end = 0;
+        const std::function<void(int)>* fn = nullptr;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    auto st = std::make_shared<State>();
+    st->next = begin;
+    st->end = end;
+    st->fn = &fn;
+
+    auto drain = [](State& s) {
+        for (int i = s.next++; i < s.end; i = s.next++) (*s.fn)(i);
+    };
+
+    for (int h = 0; h < helpers; ++h) {
+        submit([st, drain] {
+            ++st->active;
+            drain(*st);
+            if (--st->active == 0) {
+                std::lock_guard<std::mutex> lock(st->mutex);
+                st->done.notify_all();
+            }
+        });
+    }
+
+    drain(*st);
+    std::unique_lock<std::mutex> lock(st->mutex);
+    st->done.wait(lock, [&] { return st->active.load() == 0; });
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Fixed set of worker threads shared by the analysis stages.
+// parallelFor() lets the calling thread take part, so it also works when
+// called from inside a worker and never waits on tasks that did not start.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned workers);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Process-wide pool sized to the hardware (one slot is the caller)
+    static ThreadPool& Shared();
+
+    // Workers plus the calling thread
+    unsigned concurrency() const { return (unsigned)m_workers.size() + 1; }
+
+    // Run fn(i) for every i in [begin, end) and return when all are done
+    void parallelFor(int begin, int end, const std::function<void(int)>& fn);
+
+    // Fire-and-forget task on a worker thread
+    void submit(std::function<void()> task);
+
+private:
+    void WorkerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop = false;
+};
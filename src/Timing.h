@@ -0,0 +1,7 @@
+#pragma once
+#include <chrono>
+
+// Milliseconds elapsed since t0 on the steady clock
+inline double MsSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
@@ -0,0 +1,93 @@
+#include "Wavelet.h"
+#include "FFT.h"
+#include "ThreadPool.h"
+#include <cmath>
+#include <algorithm>
+
+static const double kMorletW0 = 6.0;
+
+// Scale whose wavelet peaks at angular frequency w (Torrence & Compo Fourier factors)
+static double scaleForFrequency(int wavelet, double w) {
+    if (wavelet == WAVELET_MEXICAN_HAT) return std::sqrt(2.5) / w;
+    return (kMorletW0 + std::sqrt(2.0 + kMorletW0 * kMorletW0)) / (2.0 * w);
+}
+
+// Wavelet spectrum conj(psi_hat(s*w)), real for both supported wavelets
+static double waveletSpectrum(int wavelet, double sw) {
+    if (wavelet == WAVELET_MEXICAN_HAT) {
+        static const double norm = 1.0 / std::sqrt(std::tgamma(2.5));
+        return norm * sw * sw * std::exp(-0.5 * sw * sw);
+    }
+    if (sw <= 0.0) return 0.0;   // analytic Morlet: positive frequencies only
+    static const double norm = std::pow(M_PI, -0.25);
+    const double d = sw - kMorletW0;
+    return norm * std::exp(-0.5 * d * d);
+}
+
+void Scalogram::compute(const std::vector<double>& x, unsigned signalId, double dt,
+    int wavelet, double wMin, double wMax, int scales)
+{
+    const int N = (int)x.size();
+    scales = std::max(scales, 1);
+    if (N < 2 || dt <= 0.0 || wMin <= 0.0 || wMax <= wMin) {
+        scales_ = 0;
+        length_ = 0;
+        return;
+    }
+
+    const bool newSignal = signalId != signalId_ || N != length_ || dt != dt_;
+    if (!newSignal && wavelet == wavelet_ && wMin == wMin_ && wMax == wMax_ && scales == scales_)
+        return;
+
+    // zero-padded (2x) mean-free signal spectrum, cached per signal
+    const int M = FFT::nextPow2(2 * N);
+    if (newSignal) {
+        double mean = 0.0;
+        for (double v : x) mean += v;
+        mean /= N;
+        spectrum_.assign(M, { 0.0, 0.0 });
+        for (int n = 0; n < N; ++n) spectrum_[n] = x[n] - mean;
+        FFT(M).forward(spectrum_);
+        signalId_ = signalId;
+        dt_ = dt;
+    }
+
+    length_ = N;
+    scales_ = scales;
+    wavelet_ = wavelet;
+    wMin_ = wMin;
+    wMax_ = wMax;
+
+    freqs_.resize(scales);
+    for (int s = 0; s < scales; ++s) {
+        const double t = scales > 1 ? (double)s / (scales - 1) : 0.0;
+        freqs_[s] = wMax * std::pow(wMin / wMax, t);   // log-spaced, high to low
+    }
+    power_.assign((size_t)scales * N, 0.0f);
+
+    const FFT fft(M);
+    const double dw = 2.0 * M_PI / (M * dt);
+    std::vector<float> rowMax(scales, 0.0f);
+
+    ThreadPool::Shared().parallelFor(0, scales, [&](int s) {
+        const double scale = scaleForFrequency(wavelet, freqs_[s]);
+        const double norm = std::sqrt(2.0 * M_PI * scale / dt);
+
+        std::vector<std::complex<double>> work(M);
+        for (int k = 0; k < M; ++k) {
+            const double w = (k <= M / 2 ? k : k - M) * dw;
+            work[k] = spectrum_[k] * (norm * waveletSpectrum(wavelet, scale * w));
+        }
+        fft.inverse(work);
+
+        float* out = power_.data() + (size_t)s * N;
+        float peak = 0.0f;
+        for (int n = 0; n < N; ++n) {
+            out[n] = (float)std::abs(work[n]);
+            peak = std::max(peak, out[n]);
+        }
+        rowMax[s] = peak;
+    });
+
+    maxValue_ = *std::max_element(rowMax.begin(), rowMax.end());
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+#include <complex>
+
+enum WaveletType {
+    WAVELET_MORLET = 0,
+    WAVELET_MEXICAN_HAT,
+};
+
+// Continuous wavelet transform of a uniformly sampled signal.
+// The signal spectrum is cached; every scale is one multiply against the
+// analytic wavelet spectrum plus one inverse FFT, and scales are spread over
+// the shared thread pool. Magnitudes land in one contiguous scales x N buffer.
+class Scalogram {
+public:
+    // Recompute for the given signal. signalId identifies the samples so the
+    // forward FFT is skipped while only the scale set changes.
+    void compute(const std::vector<double>& x, unsigned signalId, double dt,
+        int wavelet, double wMin, double wMax, int scales);
+
+    int scales() const { return scales_; }
+    int length() const { return length_; }
+    // |W(s, t)| row for scale index s (0 = highest frequency)
+    const float* row(int s) const { return power_.data() + (size_t)s * length_; }
+    double frequency(int s) const { return freqs_[s]; }
+    float maxValue() const { return maxValue_; }
+
+private:
+    unsigned signalId_ = ~0u;
+    int length_ = 0;
+    double dt_ = 0.0;
+    std::vector<std::complex<double>> spectrum_;
+
+    // last scale set, to skip recomputation when nothing changed
+    int wavelet_ = -1;
+    double wMin_ = 0.0, wMax_ = 0.0;
+    int scales_ = 0;
+
+    std::vector<double> freqs_;
+    std::vector<float> power_;
+    float maxValue_ = 0.0f;
+};
@@ -0,0 +1,180 @@
+#include "Welch.h"
+#include "Fourier.h"
+#include "FFT.h"
+#include "ThreadPool.h"
+#include <cmath>
+#include <algorithm>
+
+static const int kMinSegment = 16;
+static const double kZ975 = 1.959963985;   // two-sided 95%
+
+// Chi-square quantile with nu degrees of freedom at the normal quantile z (Wilson-Hilferty)
+static double chiSquareQuantile(double nu, double z) {
+    const double c = 2.0 / (9.0 * nu);
+    const double t = std::max(1.0 - c + z * std::sqrt(c), 1e-3);
+    return nu * t * t * t;
+}
+
+void WelchPSD::compute(const std::vector<double>& x, unsigned signalId, double dt,
+    int segments, double overlap)
+{
+    const int N = (int)x.size();
+    segments = std::max(segments, 1);
+    overlap = std::clamp(overlap, 0.0, 0.9);
+    if (N < kMinSegment || dt <= 0.0) {
+        mean_.clear();
+        lower_.clear();
+        upper_.clear();
+        count_ = 0;
+        length_ = 0;
+        signalId_ = ~0u;
+        return;
+    }
+
+    // longest power of two that fits the segments at this overlap
+    const double span = 1.0 + (segments - 1) * (1.0 - overlap);
+    int L = kMinSegment;
+    while (2.0 * L * span <= N) L *= 2;
+    const int H = std::max(1, (int)std::lround(L * (1.0 - overlap)));
+    const int K = std::min(segments, (N - L) / H + 1);
+
+    const bool newSignal = signalId != signalId_ || N != size_ || dt != dt_ || L != length_;
+    transformed_ = 0;
+    if (!newSignal && segments == requested_ && overlap == overlap_) return;
+    requested_ = segments;
+    overlap_ = overlap;
+
+    if (newSignal) {
+        if (L != length_) {
+            window_ = Fourier::hann(L);
+            windowPower_ = 0.0;
+            for (double w : window_) windowPower_ += w * w;
+        }
+        signalId_ = signalId;
+        size_ = N;
+        dt_ = dt;
+        length_ = L;
+        dw_ = 2.0 * M_PI / (L * dt);
+        std::fill(rowStart_.begin(), rowStart_.end(), -1);
+    }
+    hop_ = H;
+    count_ = K;
+
+    // reuse the rows of offsets seen before; new offsets take free rows
+    // first, then rows of offsets this estimate does not use
+    const int R = (int)rowStart_.size();
+    std::vector<char> used(R, 0);
+    std::vector<int> starts, rows;
+    active_.assign(K, -1);
+    for (int k = 0; k < K; ++k) {
+        auto it = std::find(rowStart_.begin(), rowStart_.end(), k * H);
+        if (it == rowStart_.end()) continue;
+        active_[k] = int(it - rowStart_.begin());
+        used[active_[k]] = 1;
+    }
+    int next = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int r = 0; r < R; ++r) {
+            if (used[r] || (pass == 0 && rowStart_[r] != -1)) continue;
+            while (next < K && active_[next] != -1) ++next;
+            if (next == K) break;
+            active_[next] = r;
+            used[r] = 1;
+        }
+    }
+    for (int k = 0; k < K; ++k) {
+        if (active_[k] == -1) {
+            active_[k] = (int)rowStart_.size();
+            rowStart_.push_back(-1);
+        }
+        if (rowStart_[active_[k]] != k * H) {
+            rowStart_[active_[k]] = k * H;
+            starts.push_back(k * H);
+            rows.push_back(active_[k]);
+        }
+    }
+    rows_.resize(rowStart_.size() * (size_t)(L / 2 + 1));
+
+    transform(x, starts, rows);
+    transformed_ = (int)starts.size();
+    average();
+}
+
+// Periodograms of the segments at `starts` into `rows`, two segments per FFT:
+// z = a + ib gives A[k] = (Z[k] + conj Z[-k]) / 2 and B[k] = (Z[k] - conj Z[-k]) / 2i.
+void WelchPSD::transform(const std::vector<double>& x, const std::vector<int>& starts,
+    const std::vector<int>& rows)
+{
+    const int L = length_;
+    const int bins = L / 2 + 1;
+    const int M = (int)starts.size();
+    const int P = (M + 1) / 2;
+    if (P == 0) return;
+    if ((int)pairs_.size() < P) pairs_.resize(P);
+
+    // one-sided power per rad/s: dt / (2 pi sum w^2) |X|^2, doubled off DC and Nyquist
+    const double c = dt_ / (2.0 * M_PI * windowPower_);
+    const FFT fft(L);
+    ThreadPool::Shared().parallelFor(0, P, [&](int p) {
+        Pair& pr = pairs_[p];
+        const int i = 2 * p;
+        const bool two = i + 1 < M;
+        auto segment = [&](std::vector<double>& s, int start) {
+            s.assign(x.begin() + start, x.begin() + start + L);
+            Fourier::zeroMean(s);
+            Fourier::applyWindow(s, window_);
+        };
+        segment(pr.a, starts[i]);
+        if (two) segment(pr.b, starts[i + 1]);
+        else pr.b.assign(L, 0.0);
+
+        pr.z.resize(L);
+        for (int n = 0; n < L; ++n) pr.z[n] = { pr.a[n], pr.b[n] };
+        fft.forward(pr.z);
+
+        double* rowA = rows_.data() + (size_t)rows[i] * bins;
+        double* rowB = two ? rows_.data() + (size_t)rows[i + 1] * bins : nullptr;
+        for (int k = 0; k < bins; ++k) {
+            const std::complex<double> zk = pr.z[k];
+            const std::complex<double> zc = std::conj(pr.z[(L - k) % L]);
+            const double scale = (k == 0 || k == L / 2) ? c : 2.0 * c;
+            rowA[k] = scale * std::norm(0.5 * (zk + zc));
+            if (rowB) rowB[k] = scale * std::norm(0.5 * (zk - zc));
+        }
+    });
+}
+
+void WelchPSD::average() {
+    const int L = length_;
+    const int K = count_;
+    const int bins = L / 2 + 1;
+    mean_.assign(bins, 0.0);
+    for (int r : active_) {
+        const double* row = rows_.data() + (size_t)r * bins;
+        for (int k = 0; k < bins; ++k) mean_[k] += row[k];
+    }
+    for (double& v : mean_) v /= K;
+
+    // overlapping segments are correlated through the window (Welch 1967):
+    // nu = 2K / (1 + 2 sum_m (1 - m/K) rho(mH)^2), rho = window autocorrelation
+    double corr = 0.0;
+    for (int m = 1; m < K && m * hop_ < L; ++m) {
+        const int s = m * hop_;
+        double rho = 0.0;
+        for (int n = 0; n + s < L; ++n) rho += window_[n] * window_[n + s];
+        rho /= windowPower_;
+        corr += (1.0 - (double)m / K) * rho * rho;
+    }
+    dof_ = 2.0 * K / (1.0 + 2.0 * corr);
+
+    const double lo = dof_ / chiSquareQuantile(dof_, kZ975);
+    const double hi = dof_ / chiSquareQuantile(dof_, -kZ975);
+    lower_.resize(bins);
+    upper_.resize(bins);
+    maxValue_ = 0.0;
+    for (int k = 0; k < bins; ++k) {
+        lower_[k] = mean_[k] * lo;
+        upper_[k] = mean_[k] * hi;
+        maxValue_ = std::max(maxValue_, mean_[k]);
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include <complex>
+
+// Welch power spectral density of a uniformly sampled signal.
+// The signal is cut into overlapping mean-free, Hann-windowed segments of a
+// power-of-two length; their periodograms are computed two per complex FFT
+// across the shared thread pool and averaged. Periodograms are kept per
+// segment offset, so while the signal and the segment length stay the same,
+// changing the segment count or overlap only transforms segments at offsets
+// not seen before. All buffers are reused between calls.
+class WelchPSD {
+public:
+    // segments: how many to average; overlap: fraction of a segment shared
+    // with the next, 0..0.9
+    void compute(const std::vector<double>& x, unsigned signalId, double dt,
+        int segments, double overlap);
+
+    // one-sided bins 0..L/2, frequency in rad/s
+    int bins() const { return (int)mean_.size(); }
+    double frequency(int k) const { return k * dw_; }
+    // averaged power per rad/s and its 95% confidence interval
+    const std::vector<double>& power() const { return mean_; }
+    const std::vector<double>& lower() const { return lower_; }
+    const std::vector<double>& upper() const { return upper_; }
+    double maxValue() const { return maxValue_; }
+
+    int segments() const { return count_; }
+    int segmentLength() const { return length_; }
+    int hop() const { return hop_; }
+    // equivalent degrees of freedom of the average (2 per independent segment)
+    double dof() const { return dof_; }
+    // segments transformed by the last compute, the rest were reused
+    int transformed() const { return transformed_; }
+
+private:
+    void transform(const std::vector<double>& x, const std::vector<int>& starts,
+        const std::vector<int>& rows);
+    void average();
+
+    unsigned signalId_ = ~0u;
+    int size_ = 0;
+    double dt_ = 0.0;
+    int length_ = 0;
+    int hop_ = 0;
+    int count_ = 0;
+    double dw_ = 0.0;
+    double dof_ = 0.0;
+    int transformed_ = 0;
+    int requested_ = 0;
+    double overlap_ = -1.0;
+
+    std::vector<double> window_;          // Hann window of length_
+    double windowPower_ = 0.0;            // sum of w^2
+
+    // periodogram rows, one per cached segment offset (-1 = free)
+    std::vector<double> rows_;
+    std::vector<int> rowStart_;
+    std::vector<int> active_;             // rows averaged by the current estimate
+
+    // per-FFT scratch: two windowed segments packed into one complex signal
+    struct Pair {
+        std::vector<double> a, b;
+        std::vector<std::complex<double>> z;
+    };
+    std::vector<Pair> pairs_;
+
+    std::vector<double> mean_, lower_, upper_;
+    double maxValue_ = 0.0;
+};
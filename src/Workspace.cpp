@@ -0,0 +1,231 @@
+#include "Workspace.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+
+static const uint32_t kWorkspaceVersion = 1;
+
+enum SectionTag : uint32_t {
+    SECTION_CONFIG = 0x464E4F43,     // "CONF"
+    SECTION_CURVE = 0x56525543,      // "CURV"
+    SECTION_LAYER = 0x5259414C,      // "LAYR"
+    SECTION_SPECTRUM = 0x43455053,   // "SPEC"
+};
+
+struct WorkspaceHeader {
+    char     magic[4];
+    uint32_t version;
+    uint64_t payloadSize;
+    uint64_t checksum;
+};
+
+static uint64_t Fnv1a(const unsigned char* p, size_t n) {
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// ---------- encoding ----------
+class PayloadWriter {
+public:
+    template <class T> void put(const T& v) { bytes_.append((const char*)&v, sizeof(v)); }
+    void putText(const std::string& s) {
+        put((uint32_t)s.size());
+        bytes_.append(s);
+        align();
+    }
+    void putDoubles(const std::vector<double>& v) {
+        put((uint64_t)v.size());
+        bytes_.append((const char*)v.data(), v.size() * sizeof(double));
+    }
+    void align() { bytes_.append((8 - bytes_.size() % 8) % 8, '\0'); }
+
+    // section: tag, index, size of the body that follows
+    size_t begin(uint32_t tag, uint32_t index) {
+        put(tag);
+        put(index);
+        put((uint64_t)0);
+        return bytes_.size();
+    }
+    void end(size_t start) {
+        align();
+        const uint64_t size = bytes_.size() - start;
+        std::memcpy(&bytes_[start - sizeof(uint64_t)], &size, sizeof(size));
+    }
+
+    const std::string& bytes() const { return bytes_; }
+
+private:
+    std::string bytes_;
+};
+
+class PayloadReader {
+public:
+    PayloadReader(const unsigned char* p, size_t n) : begin_(p), p_(p), end_(p + n) {}
+
+    template <class T> bool get(T& v) {
+        if ((size_t)(end_ - p_) < sizeof(v)) return false;
+        std::memcpy(&v, p_, sizeof(v));
+        p_ += sizeof(v);
+        return true;
+    }
+    bool getText(std::string& s) {
+        uint32_t n;
+        if (!get(n) || (size_t)(end_ - p_) < n) return false;
+        s.assign((const char*)p_, n);
+        p_ += n;
+        return align();
+    }
+    bool getDoubles(std::vector<double>& v) {
+        uint64_t n;
+        if (!get(n) || (uint64_t)(end_ - p_) / sizeof(double) < n) return false;
+        v.resize((size_t)n);
+        std::memcpy(v.data(), p_, (size_t)n * sizeof(double));
+        p_ += n * sizeof(double);
+        return true;
+    }
+    bool align() {
+        const size_t pad = (8 - (size_t)(p_ - begin_) % 8) % 8;
+        if ((size_t)(end_ - p_) < pad) return false;
+        p_ += pad;
+        return true;
+    }
+    bool skip(uint64_t n) {
+        if ((uint64_t)(end_ - p_) < n) return false;
+        p_ += n;
+        return true;
+    }
+    bool done() const { return p_ == end_; }
+    uint64_t remaining() const { return (uint64_t)(end_ - p_); }
+    const unsigned char* pos() const { return p_; }
+
+private:
+    const unsigned char* begin_;
+    const unsigned char* p_;
+    const unsigned char* end_;
+};
+
+static void PutSamples(PayloadWriter& w, const CachedSamples& s) {
+    w.putText(s.source);
+    for (float v : s.params) w.put(v);
+    w.put((int32_t)s.n);
+    w.put(s.xMin);
+    w.put(s.xMax);
+    w.putDoubles(s.values);
+}
+
+static bool GetSamples(PayloadReader& r, CachedSamples& s) {
+    int32_t n;
+    bool ok = r.getText(s.source);
+    for (float& v : s.params) ok = ok && r.get(v);
+    ok = ok && r.get(n) && r.get(s.xMin) && r.get(s.xMax) && r.getDoubles(s.values);
+    s.n = n;
+    return ok && s.n == (int)s.values.size();
+}
+
+bool SaveWorkspace(const std::string& path, const WorkspaceCache& ws, std::string& error) {
+    PayloadWriter w;
+    size_t at = w.begin(SECTION_CONFIG, 0);
+    w.putText(ws.config);
+    w.end(at);
+    if (!ws.curve.source.empty()) {
+        at = w.begin(SECTION_CURVE, 0);
+        PutSamples(w, ws.curve);
+        w.end(at);
+    }
+    for (size_t k = 0; k < ws.layers.size(); ++k) {
+        if (ws.layers[k].source.empty()) continue;
+        at = w.begin(SECTION_LAYER, (uint32_t)k);
+        PutSamples(w, ws.layers[k]);
+        w.end(at);
+    }
+    if (!ws.spectrum.source.empty()) {
+        const CachedSpectrum& s = ws.spectrum;
+        at = w.begin(SECTION_SPECTRUM, 0);
+        w.putText(s.source);
+        for (float v : s.params) w.put(v);
+        w.put(s.center);
+        w.put(s.range);
+        w.put((int32_t)s.n);
+        w.put(s.spectrum.wMax);
+        w.put(s.spectrum.maxAmp);
+        w.putDoubles(s.spectrum.freqs);
+        w.putDoubles(s.spectrum.magn);
+        w.end(at);
+    }
+
+    WorkspaceHeader h;
+    std::memcpy(h.magic, "FVWS", 4);
+    h.version = kWorkspaceVersion;
+    h.payloadSize = w.bytes().size();
+    h.checksum = Fnv1a((const unsigned char*)w.bytes().data(), w.bytes().size());
+
+    // write aside and rename, so a crash never leaves half a snapshot
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::out | std::ios::binary);
+        f.write((const char*)&h, sizeof(h));
+        f.write(w.bytes().data(), w.bytes().size());
+        f.flush();
+        if (!f) { error = "Cannot write " + tmp; return false; }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) { error = "Cannot replace " + path + ": " + ec.message(); return false; }
+    return true;
+}
+
+bool LoadWorkspace(const std::string& path, WorkspaceCache& ws, std::string& error) {
+    // one read of the whole file; every section is copied out of it anyway
+    std::ifstream f(path, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!f.is_open()) { error = "Cannot open " + path; return false; }
+    std::vector<unsigned char> file((size_t)f.tellg());
+    f.seekg(0);
+    if (!f.read((char*)file.data(), (std::streamsize)file.size())) { error = "Cannot read " + path; return false; }
+
+    WorkspaceHeader h;
+    if (file.size() < sizeof(h)) { error = path + ": truncated"; return false; }
+    std::memcpy(&h, file.data(), sizeof(h));
+    if (std::memcmp(h.magic, "FVWS", 4) != 0) { error = path + ": not a workspace snapshot"; return false; }
+    if (h.version != kWorkspaceVersion) { error = path + ": snapshot version " + std::to_string(h.version); return false; }
+    if (h.payloadSize != file.size() - sizeof(h)) { error = path + ": truncated"; return false; }
+    const unsigned char* payload = file.data() + sizeof(h);
+    if (Fnv1a(payload, (size_t)h.payloadSize) != h.checksum) { error = path + ": checksum mismatch"; return false; }
+
+    WorkspaceCache out;
+    PayloadReader r(payload, (size_t)h.payloadSize);
+    while (!r.done()) {
+        uint32_t tag, index;
+        uint64_t size;
+        if (!r.get(tag) || !r.get(index) || !r.get(size) || size > r.remaining()) {
+            error = path + ": bad section";
+            return false;
+        }
+        PayloadReader s(r.pos(), (size_t)size);
+        bool ok = true;
+        if (tag == SECTION_CONFIG) ok = s.getText(out.config);
+        else if (tag == SECTION_CURVE) ok = GetSamples(s, out.curve);
+        else if (tag == SECTION_LAYER && index < 64) {
+            if (out.layers.size() <= index) out.layers.resize(index + 1);
+            ok = GetSamples(s, out.layers[index]);
+        }
+        else if (tag == SECTION_SPECTRUM) {
+            CachedSpectrum& c = out.spectrum;
+            int32_t n;
+            ok = s.getText(c.source);
+            for (float& v : c.params) ok = ok && s.get(v);
+            ok = ok && s.get(c.center) && s.get(c.range) && s.get(n) &&
+                s.get(c.spectrum.wMax) && s.get(c.spectrum.maxAmp) &&
+                s.getDoubles(c.spectrum.freqs) && s.getDoubles(c.spectrum.magn);
+            c.n = n;
+        }
+        // unknown sections are skipped for forward compatibility
+        if (!ok || !r.skip(size)) { error = path + ": bad section"; return false; }
+    }
+    ws = std::move(out);
+    return true;
+}
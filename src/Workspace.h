@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Fourier.h"
+#include "CompiledExpr.h"
+
+// Samples of one expression on a uniform grid and the inputs that produced them
+struct CachedSamples {
+    std::string source;                 // normalized expression, empty = no entry
+    float  params[kVarCount - 1] = {};  // t, a..d when sampled
+    int    n = 0;
+    double xMin = 0.0, xMax = 0.0;
+    std::vector<double> values;
+};
+
+// Transform-view spectrum and its inputs
+struct CachedSpectrum {
+    std::string source;
+    float params[kVarCount - 1] = {};
+    float center = 0.0f, range = 0.0f;
+    int   n = 0;
+    FourierSpectrum spectrum;
+};
+
+// What a workspace snapshot holds: the config text and Scene's cached results
+struct WorkspaceCache {
+    std::string config;                 // config.ini text
+    CachedSamples curve;
+    std::vector<CachedSamples> layers;  // by layer index
+    CachedSpectrum spectrum;
+};
+
+// Binary snapshot, written next to config.ini on exit. Layout: a header
+// ("FVWS", version, payload size, FNV-1a 64 of the payload), then tagged
+// sections aligned to 8 bytes. A file of another version or with a bad
+// checksum is rejected whole; the caller then starts from config.ini alone.
+bool SaveWorkspace(const std::string& path, const WorkspaceCache& ws, std::string& error);
+// Reads the file in one go, verifies it and copies the sections out
+bool LoadWorkspace(const std::string& path, WorkspaceCache& ws, std::string& error);